@@ -0,0 +1,354 @@
+#include "bench.hpp"
+
+#include <core/history.hpp>
+#include <core/notation.hpp>
+#include <core/perft.hpp>
+#include <core/search.hpp>
+#include <core/transposition.hpp>
+
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <print>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+struct Workload {
+    enum Kind { PERFT, SEARCH };
+
+    Kind kind;
+    std::string_view fen;
+    int depth;
+
+    inline std::string_view name() const {
+        return kind == PERFT ? "perft" : "search";
+    }
+};
+
+// Never change these without saving a new baseline, the signature depends on them
+constexpr Workload workload[]{
+    {Workload::PERFT, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5},
+    {Workload::PERFT, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4},
+    {Workload::PERFT, "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6},
+    {Workload::PERFT, "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5},
+    {Workload::PERFT, "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4},
+    {Workload::PERFT, "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4},
+    {Workload::SEARCH, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 6},
+    {Workload::SEARCH, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 5},
+    {Workload::SEARCH, "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 5},
+    {Workload::SEARCH, "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 8},
+};
+
+/*
+ * Runs one entry of the workload and returns the nodes visited.
+ *
+ * Searches are limited by depth only and start from an empty table,
+ * so their node counts are deterministic.
+ */
+uint64_t run_entry(const Workload& entry, core::Board& board) {
+    if (entry.kind == Workload::PERFT) {
+        return core::perft::count_nodes(board, entry.depth);
+    }
+
+    core::History history;
+
+    static core::transposition::Table table(16);
+    table.clear();
+
+    core::search::Search search(
+        board, history, {.depth = entry.depth}, &table);
+
+    return search.run().nodes;
+}
+
+struct Result {
+    uint64_t nodes = 0;
+    double seconds = 0;
+
+    inline double nps() const { return seconds > 0 ? nodes / seconds : 0; }
+};
+
+struct Report {
+    std::vector<Result> positions;
+    Result total;
+
+    // the total node count, only changes if the generator or the search does
+    inline uint64_t signature() const { return total.nodes; }
+};
+
+// Each position is timed this many times, keeping the fastest run
+constexpr int repetitions = 3;
+
+Report run_workload() {
+    Report report;
+
+    for (const auto& entry : workload) {
+        core::Board board = core::notation::FEN::parse_string(entry.fen);
+
+        Result result;
+
+        for (int run = 0; run < repetitions; ++run) {
+            auto start = std::chrono::steady_clock::now();
+
+            result.nodes = run_entry(entry, board);
+
+            double seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start)
+                                 .count();
+
+            if (run == 0 || seconds < result.seconds) result.seconds = seconds;
+        }
+
+        report.total.nodes += result.nodes;
+        report.total.seconds += result.seconds;
+        report.positions.push_back(result);
+    }
+
+    return report;
+}
+
+/*
+ * Searches the search positions of the workload to their depth
+ * with a Lazy SMP search of 1 up to `max_threads` threads,
+ * and prints the time to reach that depth and the speedup over one thread.
+ */
+void report_smp_scaling(unsigned max_threads) {
+    core::History history;
+    core::transposition::Table table(16);
+
+    std::println("{:>7} {:>12} {:>10} {:>8}", "threads", "nodes", "time (s)",
+        "speedup");
+
+    double single = 0;
+
+    for (unsigned threads = 1; threads <= max_threads; ++threads) {
+        uint64_t nodes = 0;
+        double seconds = 0;
+
+        for (const auto& entry : workload) {
+            if (entry.kind != Workload::SEARCH) continue;
+
+            core::Board board = core::notation::FEN::parse_string(entry.fen);
+
+            // every run starts from an empty table
+            table.clear();
+
+            core::search::LazySmp search(
+                board, history, {.depth = entry.depth}, table, threads);
+
+            auto start = std::chrono::steady_clock::now();
+
+            nodes += search.run().nodes;
+
+            seconds += std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start)
+                           .count();
+        }
+
+        if (threads == 1) single = seconds;
+
+        std::println("{:>7} {:>12} {:>10.3f} {:>8.2f}", threads, nodes, seconds,
+            single / seconds);
+    }
+}
+
+void print_text(const Report& report) {
+    for (size_t index = 0; index < report.positions.size(); ++index) {
+        const auto& result = report.positions[index];
+
+        std::println("{:<6} {} {:<72} {:>10} nodes {:>12.0f} nps",
+            workload[index].name(), workload[index].depth, workload[index].fen,
+            result.nodes, result.nps());
+    }
+
+    std::println("");
+    std::println("signature: {}", report.signature());
+    std::println("nodes:     {}", report.total.nodes);
+    std::println("time:      {:.3f} s", report.total.seconds);
+    std::println("nps:       {:.0f}", report.total.nps());
+}
+
+/*
+ * Prints the report as JSON, the totals come before the positions
+ * so `read_number` finds them first.
+ */
+void print_json(const Report& report) {
+    std::println("{{");
+    std::println("  \"signature\": {},", report.signature());
+    std::println("  \"nodes\": {},", report.total.nodes);
+    std::println("  \"time\": {:.6f},", report.total.seconds);
+    std::println("  \"nps\": {:.0f},", report.total.nps());
+    std::println("  \"positions\": [");
+
+    for (size_t index = 0; index < report.positions.size(); ++index) {
+        const auto& result = report.positions[index];
+
+        std::println(
+            "    {{\"kind\": \"{}\", \"fen\": \"{}\", \"depth\": {}, "
+            "\"nodes\": {}, \"time\": {:.6f}, \"nps\": {:.0f}}}{}",
+            workload[index].name(), workload[index].fen, workload[index].depth,
+            result.nodes, result.seconds, result.nps(),
+            index + 1 < report.positions.size() ? "," : "");
+    }
+
+    std::println("  ]");
+    std::println("}}");
+}
+
+/*
+ * Parses a number taking up the whole of `text`.
+ */
+template <typename T>
+std::optional<T> parse_number(std::string_view text) {
+    T value;
+
+    auto [end, error] =
+        std::from_chars(text.data(), text.data() + text.size(), value);
+
+    if (error != std::errc() || end != text.data() + text.size()) {
+        return std::nullopt;
+    }
+
+    return value;
+}
+
+/*
+ * Reads the first number following `"key":` in a JSON text,
+ * enough for the files written by `print_json`.
+ */
+template <typename T>
+std::optional<T> read_number(const std::string& json, std::string_view key) {
+    auto at = json.find(std::format("\"{}\":", key));
+
+    if (at == std::string::npos) return std::nullopt;
+
+    at = json.find_first_not_of(" \t\n", at + key.size() + 3);
+
+    if (at == std::string::npos) return std::nullopt;
+
+    T value;
+
+    auto [end, error] =
+        std::from_chars(json.data() + at, json.data() + json.size(), value);
+
+    if (error != std::errc()) return std::nullopt;
+
+    return value;
+}
+
+/*
+ * Compares against a baseline written with --json.
+ *
+ * Fails if the signature differs
+ * or if the nodes per second dropped more than `threshold` percent.
+ *
+ * Prints to `out`, stderr when stdout holds the JSON report.
+ */
+int compare(const Report& report, const std::string& path, double threshold,
+    std::ostream& out) {
+    std::ifstream file(path);
+
+    if (!file) {
+        std::println(std::cerr, "Error:: Could not open baseline '{}'", path);
+        return 2;
+    }
+
+    std::string json((std::istreambuf_iterator<char>(file)),
+        std::istreambuf_iterator<char>());
+
+    auto signature = read_number<uint64_t>(json, "signature");
+    auto nps = read_number<double>(json, "nps");
+
+    if (!signature || !nps) {
+        std::println(std::cerr, "Error:: Malformed baseline '{}'", path);
+        return 2;
+    }
+
+    std::println(out, "");
+
+    if (*signature != report.signature()) {
+        std::println(out, "FAIL:: signature {} differs from the baseline {}",
+            report.signature(), *signature);
+        return 1;
+    }
+
+    double change = (report.total.nps() / *nps - 1) * 100;
+
+    std::println(out, "baseline:  {:.0f} nps ({:+.1f}%)", *nps, change);
+
+    if (change < -threshold) {
+        std::println(
+            out, "FAIL:: throughput regressed more than {:.1f}%", threshold);
+        return 1;
+    }
+
+    return 0;
+}
+
+int run(std::span<const std::string_view> args) {
+    bool json = false;
+    std::optional<std::string> baseline;
+    double threshold = 5;
+    unsigned smp_threads = 0;
+
+    auto usage = [] {
+        std::println(std::cerr,
+            "Usage: engine bench [--json] [--compare <baseline.json>] "
+            "[--threshold <%>] [--smp <threads>]");
+        return 2;
+    };
+
+    for (size_t index = 0; index < args.size(); ++index) {
+        auto arg = args[index];
+        bool has_value = index + 1 < args.size();
+
+        if (arg == "--json") {
+            json = true;
+        } else if (arg == "--compare" && has_value) {
+            baseline = std::string(args[++index]);
+        } else if (arg == "--threshold" && has_value) {
+            auto value = parse_number<double>(args[++index]);
+
+            if (!value) return usage();
+
+            threshold = *value;
+        } else if (arg == "--smp" && has_value) {
+            auto value = parse_number<unsigned>(args[++index]);
+
+            if (!value) return usage();
+
+            smp_threads = *value;
+        } else {
+            return usage();
+        }
+    }
+
+    // time to depth of the parallel search, instead of the workload
+    if (smp_threads) {
+        report_smp_scaling(smp_threads);
+        return 0;
+    }
+
+    Report report = run_workload();
+
+    if (json) {
+        print_json(report);
+    } else {
+        print_text(report);
+    }
+
+    if (baseline) {
+        return compare(
+            report, *baseline, threshold, json ? std::cerr : std::cout);
+    }
+
+    return 0;
+}
+
+}  // namespace bench
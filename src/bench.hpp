@@ -0,0 +1,22 @@
+#pragma once
+
+#include <span>
+#include <string_view>
+
+namespace bench {
+
+/*
+ * Runs the fixed bench workload.
+ *
+ * Usage: engine bench [--json] [--compare <baseline.json>] [--threshold <%>]
+ *                     [--smp <threads>]
+ *
+ * --smp reports the time to depth of the parallel search
+ * from 1 to the given threads instead.
+ *
+ * Returns the exit code of the command,
+ * not 0 if the comparison with the baseline fails.
+ */
+int run(std::span<const std::string_view> args);
+
+}  // namespace bench
@@ -0,0 +1,400 @@
+#include <core/generation.hpp>
+#include <core/magic.hpp>
+#include <core/notation.hpp>
+#include <core/perft.hpp>
+#include <core/types.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace core::bench {
+
+namespace magic = generation::magic;
+
+/*******************************# Measurement #********************************/
+
+constexpr int samples = 15;
+
+/*
+ * Times `run` over several samples after a warm up run
+ * and prints the median time per operation.
+ *
+ * `run` performs `ops` operations per call
+ * and returns a value that depends on their results,
+ * so the compiler cannot drop the work.
+ *
+ * The spread is the median absolute deviation over the median,
+ * it stays low unless the machine is noisy.
+ */
+template <typename Run>
+void measure(std::string_view name, uint64_t ops, Run run) {
+    uint64_t sink = run();
+
+    std::array<double, samples> ns_per_op;
+
+    for (double& sample : ns_per_op) {
+        auto start = std::chrono::steady_clock::now();
+
+        sink += run();
+
+        auto elapsed = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start);
+
+        sample = elapsed.count() / ops;
+    }
+
+    std::ranges::sort(ns_per_op);
+
+    double median = ns_per_op[samples / 2];
+
+    std::array<double, samples> deviations;
+
+    for (int index = 0; index < samples; ++index) {
+        deviations[index] = std::abs(ns_per_op[index] - median);
+    }
+
+    std::ranges::sort(deviations);
+
+    double spread = deviations[samples / 2] / median;
+
+    std::println(
+        "{:<28} {:>9.2f} ns/op {:>10.2f} Mops/s  min {:>8.2f}  ±{:>4.1f}%"
+        "  (sink {:x})",
+        name, median, 1e3 / median, ns_per_op[0], spread * 100, sink);
+}
+
+/********************************# Positions #*********************************/
+
+struct PositionSet {
+    std::string_view name;
+    std::vector<std::string_view> fens;
+};
+
+/*
+ * Representative positions for each phase of a game,
+ * the captures set is where resolving captured pieces matters the most.
+ */
+const PositionSet position_sets[]{
+    {"opening",
+        {
+            "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+            "rnbqkb1r/pp1p1ppp/4pn2/2p5/2PP4/2N5/PP2PPPP/R1BQKBNR w KQkq - 0 4",
+            "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+        }},
+    {"middlegame",
+        {
+            "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+            "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ - 0 8",
+            "2rq1rk1/pb1nbppp/1p2pn2/2pp4/2PP4/1PNBPN2/PB3PPP/2RQ1RK1 w - - 0 12",
+        }},
+    {"endgame",
+        {
+            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+            "8/8/4k3/3p4/3P4/4K3/8/8 w - - 0 1",
+            "6k1/5ppp/8/8/8/8/1r3PPP/3R2K1 w - - 0 30",
+        }},
+    {"captures",
+        {
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+            "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        }},
+};
+
+std::vector<Board> parse_set(const PositionSet& set) {
+    std::vector<Board> boards;
+
+    for (auto fen : set.fens) {
+        boards.push_back(notation::FEN::parse_string(fen));
+    }
+
+    return boards;
+}
+
+/******************************# Slider Lookups #******************************/
+
+struct SliderQuery {
+    bitboard blockers;
+    square index;
+};
+
+/*
+ * Builds a fixed set of lookups with sparse random blockers,
+ * the same for every backend so the results are comparable.
+ */
+std::vector<SliderQuery> make_slider_queries(size_t count) {
+    uint64_t seed = 0x2545F4914F6CDD1D;
+
+    auto random = [&]() {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        return seed;
+    };
+
+    std::vector<SliderQuery> queries(count);
+
+    for (auto& query : queries) {
+        query.blockers = random() & random();
+        query.index = random() % 64;
+    }
+
+    return queries;
+}
+
+void bench_sliders() {
+    const auto queries = make_slider_queries(1 << 16);
+
+    const magic::Backend selected = magic::get_backend();
+
+    struct {
+        magic::Backend backend;
+        std::string_view name;
+    } backends[]{
+        {magic::Backend::MAGIC, "magic"},
+        {magic::Backend::PEXT, "pext"},
+    };
+
+    std::println("selected slider backend: {}",
+        selected == magic::Backend::PEXT ? "pext" : "magic");
+
+    for (auto [backend, name] : backends) {
+        if (!magic::set_backend(backend)) {
+            std::println("{}: not built in or not supported by this CPU", name);
+            continue;
+        }
+
+        auto lookups = [&](bitboard (*lookup)(bitboard, square)) {
+            return [&queries, lookup]() {
+                bitboard sink = 0;
+
+                for (const auto& query : queries) {
+                    sink += lookup(query.blockers, query.index);
+                }
+
+                return (bitboard_t)sink;
+            };
+        };
+
+        measure(std::string(name) + " rooks", queries.size(),
+            lookups(magic::rooks::get_avail_moves));
+
+        measure(std::string(name) + " bishops", queries.size(),
+            lookups(magic::bishops::get_avail_moves));
+    }
+
+    magic::set_backend(selected);
+}
+
+/*******************************# Piece Lookup #*******************************/
+
+// Finds the piece on a square by scanning the piece bitboards,
+// the lookup used before the mailbox
+Piece piece_scan(const Board& board, square index) {
+    for (auto piece : Piece::All) {
+        if (board.pieces[piece][index]) return piece;
+    }
+
+    return Piece::NONE;
+}
+
+/*
+ * Compares the mailbox against scanning the bitboards
+ * on the occupied squares of the captures set.
+ */
+void bench_piece_lookup() {
+    const auto boards = parse_set(position_sets[3]);
+
+    uint64_t lookups = 0;
+
+    for (const Board& board : boards) {
+        lookups += std::popcount((bitboard_t)board.all());
+    }
+
+    constexpr int rounds = 10000;
+
+    auto run = [&](auto lookup) {
+        return [&boards, lookup]() {
+            uint64_t sink = 0;
+
+            for (int round = 0; round < rounds; ++round) {
+                for (const Board& board : boards) {
+                    for (bitboard squares = board.all(); squares != 0;
+                        squares ^= squares.LSB()) {
+                        square index = std::countr_zero((bitboard_t)squares);
+                        sink += (piece_t)lookup(board, index);
+                    }
+                }
+            }
+
+            return sink;
+        };
+    };
+
+    measure("piece mailbox", lookups * rounds,
+        run([](const Board& board, square index) {
+            return board.piece(index);
+        }));
+
+    measure("piece bitboard scan", lookups * rounds, run(piece_scan));
+}
+
+/********************************# Generation #********************************/
+
+/*
+ * Generates and counts the moves of every position set,
+ * one operation is one position.
+ */
+void bench_generation() {
+    constexpr int rounds = 2000;
+
+    for (const auto& set : position_sets) {
+        auto boards = parse_set(set);
+
+        uint64_t positions = boards.size() * rounds;
+
+        measure(std::format("generate {}", set.name), positions, [&]() {
+            generation::MoveList moves;
+            uint64_t sink = 0;
+
+            for (int round = 0; round < rounds; ++round) {
+                for (const Board& board : boards) {
+                    generation::generate_moves(board, moves);
+                    sink += moves.size();
+                }
+            }
+
+            return sink;
+        });
+
+        measure(std::format("count {}", set.name), positions, [&]() {
+            uint64_t sink = 0;
+
+            for (int round = 0; round < rounds; ++round) {
+                for (const Board& board : boards) {
+                    sink += generation::count_moves(board);
+                }
+            }
+
+            return sink;
+        });
+    }
+}
+
+/*
+ * Plays and unplays every legal move of every position set,
+ * one operation is one play and unplay pair.
+ */
+void bench_play_unplay() {
+    constexpr int rounds = 200;
+
+    std::vector<std::pair<Board, generation::MoveList>> positions;
+
+    uint64_t pairs = 0;
+
+    for (const auto& set : position_sets) {
+        for (Board& board : parse_set(set)) {
+            generation::MoveList moves;
+            generation::generate_moves(board, moves);
+
+            pairs += moves.size();
+            positions.emplace_back(board, moves);
+        }
+    }
+
+    measure("play+unplay", pairs * rounds, [&]() {
+        uint64_t sink = 0;
+
+        for (int round = 0; round < rounds; ++round) {
+            for (auto& [board, moves] : positions) {
+                for (const Move& move : moves) {
+                    auto state = board.play(move);
+                    sink += (bitboard_t)board.checkers;
+                    board.unplay(move, state);
+                }
+            }
+        }
+
+        return sink;
+    });
+}
+
+/*
+ * Compares undoing moves with `unplay` against copying the board
+ * for every ply, one operation is one perft node.
+ */
+void bench_make_unmake() {
+    constexpr int depth = 3;
+
+    std::vector<Board> boards;
+
+    for (const auto& set : position_sets) {
+        for (const Board& board : parse_set(set)) boards.push_back(board);
+    }
+
+    uint64_t nodes = 0;
+
+    for (Board& board : boards) nodes += perft::count_nodes(board, depth);
+
+    measure("perft make/unmake", nodes, [&]() {
+        uint64_t sink = 0;
+
+        for (Board& board : boards) sink += perft::count_nodes(board, depth);
+
+        return sink;
+    });
+
+    measure("perft copy-make", nodes, [&]() {
+        uint64_t sink = 0;
+
+        for (const Board& board : boards) {
+            sink += perft::count_nodes_copy_make(board, depth);
+        }
+
+        return sink;
+    });
+}
+
+/*********************************# Notation #*********************************/
+
+void bench_fen_parse() {
+    constexpr int rounds = 500;
+
+    std::vector<std::string_view> fens;
+
+    for (const auto& set : position_sets) {
+        fens.insert(fens.end(), set.fens.begin(), set.fens.end());
+    }
+
+    measure("FEN parse_string", fens.size() * rounds, [&]() {
+        uint64_t sink = 0;
+
+        for (int round = 0; round < rounds; ++round) {
+            for (auto fen : fens) {
+                sink += (bitboard_t)notation::FEN::parse_string(fen).all();
+            }
+        }
+
+        return sink;
+    });
+}
+
+}  // namespace core::bench
+
+int main() {
+    core::bench::bench_sliders();
+    core::bench::bench_piece_lookup();
+    core::bench::bench_generation();
+    core::bench::bench_play_unplay();
+    core::bench::bench_make_unmake();
+    core::bench::bench_fen_parse();
+}
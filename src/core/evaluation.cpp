@@ -0,0 +1,199 @@
+#include "evaluation.hpp"
+
+#include <core/generation.hpp>
+
+#include <algorithm>
+#include <bit>
+
+namespace core {
+
+using evaluation::score_t;
+
+/*
+ * Bonus of each piece on each square for white, drawn with rank 8 on top.
+ *
+ * The tables are symmetric between the files,
+ * so it does not matter that columns start at the h file.
+ */
+// clang-format off
+constexpr score_t square_bonus[6][64]{
+    // pawns
+    {  0,  0,  0,  0,  0,  0,  0,  0,
+      50, 50, 50, 50, 50, 50, 50, 50,
+      10, 10, 20, 30, 30, 20, 10, 10,
+       5,  5, 10, 25, 25, 10,  5,  5,
+       0,  0,  0, 20, 20,  0,  0,  0,
+       5, -5,-10,  0,  0,-10, -5,  5,
+       5, 10, 10,-20,-20, 10, 10,  5,
+       0,  0,  0,  0,  0,  0,  0,  0 },
+    // knights
+    {-50,-40,-30,-30,-30,-30,-40,-50,
+     -40,-20,  0,  0,  0,  0,-20,-40,
+     -30,  0, 10, 15, 15, 10,  0,-30,
+     -30,  5, 15, 20, 20, 15,  5,-30,
+     -30,  0, 15, 20, 20, 15,  0,-30,
+     -30,  5, 10, 15, 15, 10,  5,-30,
+     -40,-20,  0,  5,  5,  0,-20,-40,
+     -50,-40,-30,-30,-30,-30,-40,-50 },
+    // bishops
+    {-20,-10,-10,-10,-10,-10,-10,-20,
+     -10,  0,  0,  0,  0,  0,  0,-10,
+     -10,  0,  5, 10, 10,  5,  0,-10,
+     -10,  5,  5, 10, 10,  5,  5,-10,
+     -10,  0, 10, 10, 10, 10,  0,-10,
+     -10, 10, 10, 10, 10, 10, 10,-10,
+     -10,  5,  0,  0,  0,  0,  5,-10,
+     -20,-10,-10,-10,-10,-10,-10,-20 },
+    // rooks
+    {  0,  0,  0,  0,  0,  0,  0,  0,
+       5, 10, 10, 10, 10, 10, 10,  5,
+      -5,  0,  0,  0,  0,  0,  0, -5,
+      -5,  0,  0,  0,  0,  0,  0, -5,
+      -5,  0,  0,  0,  0,  0,  0, -5,
+      -5,  0,  0,  0,  0,  0,  0, -5,
+      -5,  0,  0,  0,  0,  0,  0, -5,
+       0,  0,  0,  5,  5,  0,  0,  0 },
+    // queens
+    {-20,-10,-10, -5, -5,-10,-10,-20,
+     -10,  0,  0,  0,  0,  0,  0,-10,
+     -10,  0,  5,  5,  5,  5,  0,-10,
+      -5,  0,  5,  5,  5,  5,  0, -5,
+      -5,  0,  5,  5,  5,  5,  0, -5,
+     -10,  0,  5,  5,  5,  5,  0,-10,
+     -10,  0,  0,  0,  0,  0,  0,-10,
+     -20,-10,-10, -5, -5,-10,-10,-20 },
+    // kings, kept safe behind the pawns
+    {-30,-40,-40,-50,-50,-40,-40,-30,
+     -30,-40,-40,-50,-50,-40,-40,-30,
+     -30,-40,-40,-50,-50,-40,-40,-30,
+     -30,-40,-40,-50,-50,-40,-40,-30,
+     -20,-30,-30,-40,-40,-30,-30,-20,
+     -10,-20,-20,-20,-20,-20,-20,-10,
+      20, 20,  0,  0,  0,  0, 20, 20,
+      20, 30, 10,  0,  0, 10, 30, 20 },
+};
+// clang-format on
+
+/*
+ * Material and piece placement of one side.
+ */
+template <color_t color>
+static score_t evaluate_side(const Board& board) {
+    score_t score = 0;
+
+    for (Piece piece : Piece::All) {
+        bitboard pieces = board.pieces_of(color, piece);
+
+        for (; pieces != 0; pieces ^= pieces.LSB()) {
+            square index = std::countr_zero((bitboard_t)pieces);
+
+            // the tables are drawn from white's side, rank 8 first
+            uint8_t row = color ? 7 - index.row() : index.row();
+
+            score += evaluation::piece_values[piece];
+            score += square_bonus[piece][row * 8 + index.column()];
+        }
+    }
+
+    return score;
+}
+
+/*
+ * Returns a static score of the board for the side to move.
+ */
+score_t evaluation::evaluate(const Board& board) {
+    score_t score =
+        evaluate_side<Color::WHITE>(board) - evaluate_side<Color::BLACK>(board);
+
+    return board.active_color.isWhite() ? score : -score;
+}
+
+/*
+ * Static exchange evaluation, the material won by the side to move
+ * once every capture on the destination of `move` is played out,
+ * each side capturing with its least valuable piece
+ * and free to stop when going on would lose more.
+ *
+ * The attackers are queried again after each capture,
+ * with the capturing piece gone from the occupancy,
+ * so sliders lined up behind it join the exchange.
+ */
+score_t evaluation::see(const Board& board, Move move) {
+    if (move.is_castle()) return 0;
+
+    square from = move.from(), to = move.to();
+
+    bitboard occupancy = board.all();
+
+    // gains of the side to move after each capture of the sequence
+    score_t gain[32];
+    int captures = 0;
+
+    Piece victim = board.piece(to);
+
+    if (move.is_en_passant()) {
+        victim = Piece::PAWNS;
+
+        square captured = board.active_color.isWhite() ? to.down() : to.up();
+        occupancy &= ~captured.bb();
+    }
+
+    gain[0] = victim.isNone() ? 0 : piece_values[victim];
+
+    // value of the piece standing on the square, the next one captured
+    score_t standing = piece_values[board.piece(from)];
+
+    if (move.is_promotion()) {
+        gain[0] += piece_values[move.promotion()] - piece_values[Piece::PAWNS];
+        standing = piece_values[move.promotion()];
+    }
+
+    occupancy &= ~from.bb();
+
+    Color side = !board.active_color;
+
+    while (captures + 1 < int(std::size(gain))) {
+        bitboard attackers =
+            generation::attackers_to(board, to, occupancy) & board.colors[side];
+
+        if (!attackers) break;
+
+        Piece attacker = Piece::NONE;
+        bitboard candidates = 0;
+
+        for (Piece piece : Piece::All) {
+            candidates = attackers & board.pieces[piece];
+
+            if (candidates) {
+                attacker = piece;
+                break;
+            }
+        }
+
+        // the king cannot capture a defended piece
+        if (attacker.isKing() &&
+            (generation::attackers_to(board, to, occupancy) &
+                board.colors[!side])) {
+            break;
+        }
+
+        ++captures;
+        gain[captures] = standing - gain[captures - 1];
+
+        standing = piece_values[attacker];
+
+        occupancy &= ~(candidates & -candidates);
+
+        side = !side;
+    }
+
+    // each side only captures if it does not lose by it
+    while (captures > 0) {
+        gain[captures - 1] = -std::max(-gain[captures - 1], gain[captures]);
+        --captures;
+    }
+
+    return gain[0];
+}
+
+}  // namespace core
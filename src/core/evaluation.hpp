@@ -0,0 +1,18 @@
+#pragma once
+
+#include <core/types.hpp>
+
+#include <array>
+
+namespace core::evaluation {
+
+// Scores are in centipawns from the point of view of the side to move
+using score_t = int;
+
+constexpr std::array<score_t, 6> piece_values{100, 320, 330, 500, 900, 0};
+
+score_t evaluate(const Board& board);
+
+score_t see(const Board& board, Move move);
+
+}  // namespace core::evaluation
@@ -7,529 +7,906 @@
 
 namespace core {
 
+/****************************# Precomputed Tables #****************************/
+
+//
+consteval std::array<bitboard, 64> intialize_knight_table() {
+    std::array<bitboard, 64> moves = {0};
+
+    for (square index = 0; index < 64; ++index) {
+        uint8_t row = index.row();
+        uint8_t column = index.column();
+
+        auto move_set = [&](int row, int col) {
+            if (row >= 0 && row < 8 && col >= 0 && col < 8)
+                moves[index] |= square::at(row, col).bb();
+        };
+
+        move_set(row + 2, column + 1);
+        move_set(row + 1, column + 2);
+        move_set(row - 1, column + 2);
+        move_set(row - 2, column + 1);
+        move_set(row - 2, column - 1);
+        move_set(row - 1, column - 2);
+        move_set(row + 1, column - 2);
+        move_set(row + 2, column - 1);
+    }
+
+    return moves;
+};
+
+constexpr auto knights_moves = intialize_knight_table();
+
+//
+consteval std::array<bitboard, 64> intialize_king_table() {
+    std::array<bitboard, 64> moves = {0};
+
+    for (square index = 0; index < 64; ++index) {
+        uint8_t row = index.row();
+        uint8_t column = index.column();
+
+        auto move_set = [&](int row, int col) {
+            if (row >= 0 && row < 8 && col >= 0 && col < 8)
+                moves[index] |= square::at(row, col).bb();
+        };
+
+        move_set(row + 1, column + 1);
+        move_set(row + 1, column);
+        move_set(row + 1, column - 1);
+
+        move_set(row, column + 1);
+        move_set(row, column - 1);
+
+        move_set(row - 1, column + 1);
+        move_set(row - 1, column);
+        move_set(row - 1, column - 1);
+    }
+
+    return moves;
+}
+
+constexpr auto king_moves = intialize_king_table();
+
+struct SquarePairTables {
+    // squares strictly between two aligned squares
+    std::array<std::array<bitboard, 64>, 64> between;
+    // the full rank, file or diagonal going through two aligned squares
+    std::array<std::array<bitboard, 64>, 64> line;
+};
+
+// Both tables are empty for squares that are not aligned
+consteval SquarePairTables intialize_square_pair_tables() {
+    SquarePairTables tables = {};
+
+    constexpr int directions[8][2]{
+        {1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+    for (square from = 0; from < 64; ++from) {
+        for (auto [drow, dcol] : directions) {
+            bitboard ray = 0;
+            bitboard line = from.bb();
+
+            // the whole line is the ray in both directions
+            for (int sign : {1, -1}) {
+                int row = from.row() + sign * drow;
+                int col = from.column() + sign * dcol;
+
+                for (; row >= 0 && row < 8 && col >= 0 && col < 8;
+                    row += sign * drow, col += sign * dcol) {
+                    line |= square::at(row, col).bb();
+                }
+            }
+
+            int row = from.row() + drow;
+            int col = from.column() + dcol;
+
+            for (; row >= 0 && row < 8 && col >= 0 && col < 8;
+                row += drow, col += dcol) {
+                square to = square::at(row, col);
+
+                tables.between[from][to] = ray;
+                tables.line[from][to] = line;
+
+                ray |= to.bb();
+            }
+        }
+    }
+
+    return tables;
+}
+
+constexpr auto square_pairs = intialize_square_pair_tables();
+
+constexpr auto& between_squares = square_pairs.between;
+constexpr auto& line_squares = square_pairs.line;
+
+/*
+ * Constants and directions of a side known at compile time,
+ * so the generators of each color are straight-line code.
+ */
+template <color_t us>
+struct Side {
+    using masks = bitboard::masks;
+
+    static constexpr color_t them = !us;
+
+    static constexpr bitboard back_rank = us ? masks::rank(0) : masks::rank(7);
+    static constexpr bitboard last_rank = us ? masks::rank(7) : masks::rank(0);
+
+    // rank reached by the pawns that can still advance a second time
+    static constexpr bitboard double_push_rank =
+        us ? masks::rank(2) : masks::rank(5);
+
+    static inline constexpr bitboard forward(bitboard bb, uint8_t shift) {
+        return us ? bb << shift : bb >> shift;
+    }
+
+    // square `rows` behind `index` from the point of view of the side
+    static inline constexpr square behind(square index, uint8_t rows = 1) {
+        return us ? index.down(rows) : index.up(rows);
+    }
+
+    // squares attacked by a set of pawns of the side
+    static inline constexpr bitboard pawn_attacks(bitboard pawns) {
+        bitboard left = pawns.exclude(masks::file(7));
+        bitboard right = pawns.exclude(masks::file(0));
+
+        return (forward(left, 8) << 1) | (forward(right, 8) >> 1);
+    }
+};
+
+/*
+ * Returns the en passant target square as a bitboard,
+ * empty if there is none.
+ */
+static bitboard en_passant_bb(const Board& board) {
+    if (board.en_passant_target_square == square::out_of_bounds) return 0;
+
+    return board.en_passant_target_square.bb();
+}
+
 /***************************# Main Generation Path #***************************/
 
 /*
- * Returns a reference to the next available Move slot
- * and advances the internal insertion index.
+ * Reads the attack and pin data kept in the state of the board.
+ *
+ * Splits the pinned pieces into those that can slide along the pin
+ * and those that cannot move at all.
  */
-Move& generation::GenerationContext::next() { return moves.at(nxt++); }
+generation::GenerationContext::GenerationContext(const Board& board)
+    : board(board) {
+    set_targets(bitboard::masks::fullboard);
+
+    attacked_squares = board.king_danger;
+
+    in_check = board.checkers != 0;
+
+    if (in_check) {
+        can_block_check =
+            generation::get_bitboard_check_blocks(board, allowed_squares);
+    }
+
+    bitboard pinned_pieces = board.pinned;
+
+    if (pinned_pieces == 0) return;
+
+    square iking = std::countr_zero((bitboard_t)board.allied(Piece::KINGS));
+
+    pinned.partial = pinned_pieces.mask(board.queens);
+
+    pinned.partial |= pinned_pieces.mask(board.rooks).mask(
+        magic::rooks::get_slider(iking));
+
+    pinned.partial |= pinned_pieces.mask(board.bishops).mask(
+        magic::bishops::get_slider(iking));
+
+    pinned.absolute = pinned_pieces.exclude(pinned.partial);
+}
 
 /*
  * Generates individual Move objects from precomputed bitboards.
  *
  * Iterates over all set bits in `moves`, treating each bit as a destination
- * square reachable by `moved` from `origin`.
+ * square reachable from `origin`.
  *
- * If the destination square is also set in `captures`, the move is marked
- * as a capture and the captured piece is read from the board at that square.
+ * If the destination square is also set in `captures`,
+ * the move is flagged as a capture.
  */
 void generation::GenerationContext::bulk(
-    Piece moved, square origin, bitboard moves, bitboard captures) {
+    square origin, bitboard moves, bitboard captures) {
+    if (counting()) {
+        counted += std::popcount((bitboard_t)moves);
+        return;
+    }
+
     for (; moves != 0; moves ^= moves.LSB()) {
         square index = std::countr_zero((bitboard_t)moves);
 
-        Move& move = this->next();
+        add(Move(origin, index, captures[index] ? Move::CAPTURE : Move::QUIET));
+    }
+}
+
+/*
+ * Generates all legal moves for the side to move.
+ *
+ * Returns a copy of the generated moves in a new vector,
+ * prefer the `MoveList` overload on hot paths.
+ */
+std::vector<Move> generation::generate_moves(const Board& board) {
+    MoveList moves;
 
-        move.moved = moved;
+    generation::generate_moves(board, moves);
 
-        move.from = origin;
-        move.to = index;
+    return std::vector(moves.begin(), moves.end());
+}
 
-        if (captures[index]) {
-            move.target = board.piece(move.to);
-        }
+/*
+ * Runs every piece generator with the filters set in the context.
+ */
+template <color_t us>
+static void generate_pieces(generation::GenerationContext& context) {
+    if (context.in_check && !context.can_block_check) {
+        generation::generate_moves_king<us>(context);
+        return;
     }
+
+    generation::generate_moves_pawn<us>(context);
+    generation::generate_moves_knight(context);
+    generation::generate_moves_slider<Piece::ROOKS>(context);
+    generation::generate_moves_slider<Piece::BISHOPS>(context);
+    generation::generate_moves_slider<Piece::QUEENS>(context);
+    generation::generate_moves_king<us>(context);
+}
+
+template <color_t us>
+static void generate_stage(
+    generation::GenerationContext& context, generation::MoveList& moves) {
+    context.moves = &moves;
+
+    generate_pieces<us>(context);
 }
 
 /*
- * Returns a copy of all moves generated so far.
- *
- * Copies the range `[moves.begin(), moves.begin() + nxt)` into a new vector,
- * containing only the moves that were written via the generation context.
+ * Generates legal captures (en passant included) and all promotions.
  */
-std::vector<Move> generation::GenerationContext::get_generated_moves() {
-    return std::vector(moves.begin(), moves.begin() + nxt);
+template <color_t us>
+static void generate_captures(
+    generation::GenerationContext& context, generation::MoveList& moves) {
+    auto& board = context.board;
+
+    context.set_targets(board.colors[Side<us>::them]);
+    context.targets[Piece::PAWNS] |= en_passant_bb(board);
+    context.movable = bitboard::masks::fullboard;
+    context.promotions = true;
+
+    generate_stage<us>(context, moves);
 }
 
 /*
- * Generates all legal moves for the side to move.
- *
- * Initializes a GenerationContext for the given board
- * to store auxiliary calculation
+ * Generates legal moves that neither capture nor promote, castling included.
  */
-std::vector<Move> generation::generate_moves(const Board& board) {
-    GenerationContext context(board);
-
-    generation::get_bitboard_squares_attacked(
-        context, context.attacked_squares);
+template <color_t us>
+static void generate_quiets(
+    generation::GenerationContext& context, generation::MoveList& moves) {
+    auto& board = context.board;
 
-    generation::get_bitboard_pieces_pinned(
-        context, context.pinned.absolute, context.pinned.partial);
+    context.set_targets(~board.all());
+    context.targets[Piece::PAWNS] &= ~en_passant_bb(board);
+    context.movable = bitboard::masks::fullboard;
+    context.promotions = false;
 
-    context.in_check =
-        0 != context.board.allied(Piece::KINGS).mask(context.attacked_squares);
+    generate_stage<us>(context, moves);
+}
 
-    if (context.in_check) {
-        // TODO: check generation path (WORKING 0N THIS)
-        // TEST: MAKE TESTS FOR THIS
-        bool can_block_check = generation::get_bitboard_check_blocks(
-            context, context.allowed_squares);
-
-        if (!can_block_check) {
-            generate_moves_king(context);
-            return context.get_generated_moves();
-        }
-    }
+/*
+ * Generates every legal move while the side to move is in check.
+ *
+ * Only king moves if the check cannot be blocked,
+ * otherwise blocks and captures of the checking piece as well.
+ */
+template <color_t us>
+static void generate_evasions(
+    generation::GenerationContext& context, generation::MoveList& moves) {
+    assert(context.in_check);
 
-    generation::generate_moves_pawn(context);
-    generation::generate_moves_knight(context);
-    generation::generate_moves_rook(context);
-    generation::generate_moves_bishop(context);
-    generation::generate_moves_queen(context);
-    generation::generate_moves_king(context);
+    context.set_targets(bitboard::masks::fullboard);
+    context.movable = bitboard::masks::fullboard;
+    context.promotions = true;
 
-    return context.get_generated_moves();
+    generate_stage<us>(context, moves);
 }
 
-/***************************# Pawn Move Generation #***************************/
+/*
+ * Generates quiet moves that give check, directly or by discovering a slider.
+ *
+ * Promotions are not included, they belong to the captures stage.
+ */
+template <color_t us>
+static void generate_quiet_checks(
+    generation::GenerationContext& context, generation::MoveList& moves) {
+    namespace magic = generation::magic;
+    using side = Side<us>;
 
-//
-void generation::generate_moves_pawn(GenerationContext& context) {
     auto& board = context.board;
 
-    bitboard pawns = board.allied(Piece::PAWNS);
+    bitboard enemy_king = board.pieces_of(side::them, Piece::KINGS);
 
-    bitboard pawns_pinned = pawns.mask(context.pinned.absolute);
+    if (enemy_king == 0) return;
 
-    pawns = pawns ^ pawns_pinned;
+    square iking = std::countr_zero((bitboard_t)enemy_king);
 
-    bitboard capturable = board.enemies();
+    bitboard allies = board.colors[us];
+    bitboard empty = ~board.all();
     bitboard blockers = board.all();
 
-    // set bit for en passant capture
-    capturable |= board.en_passant_target_square.bb();
+    struct {
+        bitboard diagonal, straight;
+    } king_rays;
 
-    // Advance the pawns then remove those who were blocked
-    bitboard advances_single = pawns;
-    advances_single = advances_single.forward(board.active_color, 8);
-    advances_single = advances_single.exclude(blockers);
+    king_rays.diagonal = magic::bishops::get_avail_moves(blockers, iking);
+    king_rays.straight = magic::rooks::get_avail_moves(blockers, iking);
 
-    bitboard pawns_can_advance_again = board.active_color.isWhite()
-        ? bitboard::masks::rank(2)
-        : bitboard::masks::rank(5);
+    // Allied pieces that are the only blocker between
+    // an allied slider and the enemy king
 
-    // Advance the pawns that were not blocked
-    bitboard advances_double = advances_single.mask(pawns_can_advance_again);
-    advances_double = advances_double.forward(board.active_color, 8);
-    advances_double = advances_double.exclude(blockers);
+    bitboard discoverers = 0;
 
-    // Advance the pawns to a capture position
+    bitboard candidates =
+        bitboard(king_rays.diagonal | king_rays.straight).mask(allies);
 
-    // Add pinned pawns that can capture
-    bitboard king_front =
-        board.allied(Piece::KINGS).forward(board.active_color, 8);
+    bitboard diagonal_sliders = allies.mask(board.bishops | board.queens);
+    bitboard straight_sliders = allies.mask(board.rooks | board.queens);
 
-    square iking = std::countr_zero((bitboard_t)board.allied(Piece::KINGS));
+    for (; candidates != 0; candidates ^= candidates.LSB()) {
+        bitboard candidate = candidates.LSB();
 
-    bitboard side_right =
-        bitboard::masks::file(iking.column()) - bitboard::masks::file(0);
-    bitboard side_left = ~side_right;
+        bitboard diagonal =
+            magic::bishops::get_avail_moves(blockers ^ candidate, iking);
+        bitboard straight =
+            magic::rooks::get_avail_moves(blockers ^ candidate, iking);
 
-    bitboard slider = magic::bishops::get_slider(iking);
-    side_right &= slider;
-    side_left &= slider;
+        bitboard sliders = diagonal.mask(diagonal_sliders) |
+            straight.mask(straight_sliders);
 
-    bitboard capture_direction = board.allied(Piece::KINGS) - 1;
+        if (sliders != 0) discoverers |= candidate;
+    }
 
-    if (board.active_color.isWhite()) capture_direction = ~capture_direction;
+    // squares from which each piece attacks the enemy king
+    context.set_targets(0);
 
-    side_left &= capture_direction;
-    side_right &= capture_direction;
+    context.targets[Piece::PAWNS] = Side<side::them>::pawn_attacks(enemy_king);
+    context.targets[Piece::KNIGHTS] = knights_moves[iking];
+    context.targets[Piece::BISHOPS] = king_rays.diagonal;
+    context.targets[Piece::ROOKS] = king_rays.straight;
+    context.targets[Piece::QUEENS] = king_rays.diagonal | king_rays.straight;
 
-    bitboard pinned_left = pawns_pinned.mask(side_left);
-    bitboard pinned_right = pawns_pinned.mask(side_right);
+    for (bitboard& target : context.targets) target &= empty;
 
-    bitboard captures_left = pawns | pinned_left;
-    bitboard captures_right = pawns | pinned_right;
+    context.targets[Piece::PAWNS] &= ~en_passant_bb(board);
+    context.movable = ~discoverers;
+    context.promotions = false;
 
-    // Remove pawns that will overflow
-    captures_left = captures_left.exclude(bitboard::masks::file(7));
-    captures_right = captures_right.exclude(bitboard::masks::file(0));
+    generate_stage<us>(context, moves);
 
-    // Move pawns to capture
-    captures_left = captures_left.forward(board.active_color, 8) << 1;
-    captures_right = captures_right.forward(board.active_color, 8) >> 1;
+    // castles whose rook lands on a square attacking the enemy king
+    constexpr uint8_t row = us ? 0 : 7;
+    constexpr square from = square::at(row, 3);
 
-    // keep the pawns that are over an enemy piece
-    captures_left = captures_left.mask(capturable);
-    captures_right = captures_right.mask(capturable);
+    bitboard king = board.pieces_of(us, Piece::KINGS);
 
-    for (auto moves :
-        {&advances_single, &advances_double, &captures_left, &captures_right}) {
-        *moves = moves->mask(context.allowed_squares);
-    }
+    if (king[from]) {
+        auto castle = [&](square to, square corner, square rook_to) {
+            // the king leaving the line is generated with the discoverers
+            if (discoverers[from] && !line_squares[iking][from][to]) return;
 
-    for (; advances_single != 0; advances_single ^= advances_single.LSB()) {
-        square index = std::countr_zero((bitboard_t)advances_single);
+            bitboard occupancy = board.all() ^ king ^ corner.bb();
+            occupancy |= to.bb() | rook_to.bb();
 
-        Move& m = context.next();
+            if (magic::rooks::get_avail_moves(occupancy, rook_to)[iking] ||
+                discoverers[corner]) {
+                context.targets[Piece::KINGS] |= to.bb();
+            }
+        };
 
-        m.moved = Piece::PAWNS;
-        m.from = board.active_color.isWhite() ? index.down() : index.up();
-        m.to = index;
-    }
+        context.set_targets(0);
 
-    for (; advances_double != 0; advances_double ^= advances_double.LSB()) {
-        square index = std::countr_zero((bitboard_t)advances_double);
+        castle(from + 2, square::at(row, 7), from + 1);
+        castle(from - 2, square::at(row, 0), from - 1);
 
-        Move& m = context.next();
+        context.movable = king;
 
-        m.moved = Piece::PAWNS;
-        m.from = board.active_color.isWhite() ? index.down(2) : index.up(2);
-        m.to = index;
-
-        m.en_passant = true;
+        generate_stage<us>(context, moves);
     }
 
-    for (; captures_left != 0; captures_left ^= captures_left.LSB()) {
-        square index = std::countr_zero((bitboard_t)captures_left);
+    // any quiet move that leaves the line to the king gives check
+    for (; discoverers != 0; discoverers ^= discoverers.LSB()) {
+        square index = std::countr_zero((bitboard_t)discoverers);
 
-        Move& m = context.next();
+        context.set_targets(empty.exclude(line_squares[iking][index]));
+        context.targets[Piece::PAWNS] &= ~en_passant_bb(board);
+        context.movable = index.bb();
 
-        m.moved = Piece::PAWNS;
-        m.from =
-            (board.active_color.isWhite() ? index.down() : index.up()).right();
-        m.to = index;
-        m.target = board.piece(m.to);
+        generate_stage<us>(context, moves);
+    }
+}
 
-        if (index == board.en_passant_target_square) {
-            m.en_passant = true;
-            m.target = Piece::PAWNS;
-        }
+/*
+ * Generates all legal moves of `us`, evasions if in check.
+ */
+template <color_t us>
+static void generate_legal(
+    generation::GenerationContext& context, generation::MoveList& moves) {
+    if (context.in_check) {
+        generate_evasions<us>(context, moves);
+        return;
     }
 
-    for (; captures_right != 0; captures_right ^= captures_right.LSB()) {
-        square index = std::countr_zero((bitboard_t)captures_right);
+    generate_captures<us>(context, moves);
+    generate_quiets<us>(context, moves);
+}
 
-        Move& m = context.next();
+/*
+ * Generates all legal moves for the side to move into `moves`.
+ *
+ * The list is cleared first.
+ * Initializes a GenerationContext for the given board
+ * to store auxiliary calculation,
+ * the side to move is only checked here.
+ */
+void generation::generate_moves(const Board& board, MoveList& moves) {
+    moves.clear();
 
-        m.moved = Piece::PAWNS;
-        m.from =
-            (board.active_color.isWhite() ? index.down() : index.up()).left();
-        m.to = index;
-        m.target = board.piece(m.to);
+    GenerationContext context(board);
 
-        if (index == board.en_passant_target_square) {
-            m.en_passant = true;
-            m.target = Piece::PAWNS;
-        }
+    if (board.active_color.isWhite()) {
+        generate_legal<Color::WHITE>(context, moves);
+    } else {
+        generate_legal<Color::BLACK>(context, moves);
     }
 }
 
-/**************************# Knight Move Generation #**************************/
+/*
+ * Returns the number of legal moves for the side to move.
+ *
+ * Uses the same context as `generate_moves`,
+ * but adds up the destination bitboards instead of building moves.
+ * Meant for the leaves of perft.
+ */
+uint64_t generation::count_moves(const Board& board) {
+    // the context starts with every destination allowed,
+    // so all moves are counted at once instead of by stage
+    GenerationContext context(board);
 
-//
-consteval std::array<bitboard, 64> intialize_knight_table() {
-    std::array<bitboard, 64> moves = {0};
+    if (board.active_color.isWhite()) {
+        generate_pieces<Color::WHITE>(context);
+    } else {
+        generate_pieces<Color::BLACK>(context);
+    }
 
-    for (square index = 0; index < 64; ++index) {
-        uint8_t row = index.row();
-        uint8_t column = index.column();
+    return context.counted;
+}
 
-        auto move_set = [&](int row, int col) {
-            if (row >= 0 && row < 8 && col >= 0 && col < 8)
-                moves[index] |= square::at(row, col).bb();
-        };
+void generation::generate_captures(
+    GenerationContext& context, MoveList& moves) {
+    if (context.board.active_color.isWhite()) {
+        core::generate_captures<Color::WHITE>(context, moves);
+    } else {
+        core::generate_captures<Color::BLACK>(context, moves);
+    }
+}
 
-        move_set(row + 2, column + 1);
-        move_set(row + 1, column + 2);
-        move_set(row - 1, column + 2);
-        move_set(row - 2, column + 1);
-        move_set(row - 2, column - 1);
-        move_set(row - 1, column - 2);
-        move_set(row + 1, column - 2);
-        move_set(row + 2, column - 1);
+void generation::generate_quiets(GenerationContext& context, MoveList& moves) {
+    if (context.board.active_color.isWhite()) {
+        core::generate_quiets<Color::WHITE>(context, moves);
+    } else {
+        core::generate_quiets<Color::BLACK>(context, moves);
     }
+}
 
-    return moves;
-};
+void generation::generate_evasions(
+    GenerationContext& context, MoveList& moves) {
+    if (context.board.active_color.isWhite()) {
+        core::generate_evasions<Color::WHITE>(context, moves);
+    } else {
+        core::generate_evasions<Color::BLACK>(context, moves);
+    }
+}
 
-constexpr auto knights_moves = intialize_knight_table();
+void generation::generate_quiet_checks(
+    GenerationContext& context, MoveList& moves) {
+    if (context.board.active_color.isWhite()) {
+        core::generate_quiet_checks<Color::WHITE>(context, moves);
+    } else {
+        core::generate_quiet_checks<Color::BLACK>(context, moves);
+    }
+}
+
+/***************************# Pawn Move Generation #***************************/
+
+/*
+ * Generates the pushes and captures of a set of pawns,
+ * restricted to the squares in `allowed`.
+ */
+template <color_t us>
+static void generate_moves_pawn_set(
+    generation::GenerationContext& context, bitboard pawns, bitboard allowed) {
+    using side = Side<us>;
 
-void generation::generate_moves_knight(GenerationContext& context) {
     auto& board = context.board;
 
-    bitboard knights = board.allied(Piece::KNIGHTS);
-    knights = knights.exclude(context.pinned.absolute);
+    bitboard capturable = board.colors[side::them];
+    bitboard blockers = board.all();
 
-    bitboard capturable = board.enemies();
-    bitboard blockers = board.allies();
+    allowed &= context.allowed_squares;
 
-    for (; knights != 0; knights ^= knights.LSB()) {
-        square index = std::countr_zero((bitboard_t)knights);
+    // Advance the pawns then remove those who were blocked
+    bitboard advances_single = side::forward(pawns, 8).exclude(blockers);
 
-        bitboard moves = knights_moves[index].exclude(blockers);
-        moves = moves.mask(context.allowed_squares);
-        context.bulk(Piece::KNIGHTS, index, moves, capturable);
+    // Advance the pawns that were not blocked
+    bitboard advances_double = advances_single.mask(side::double_push_rank);
+    advances_double = side::forward(advances_double, 8).exclude(blockers);
+
+    // Remove pawns that will overflow
+    bitboard captures_left = pawns.exclude(bitboard::masks::file(7));
+    bitboard captures_right = pawns.exclude(bitboard::masks::file(0));
+
+    // Move pawns to capture
+    captures_left = side::forward(captures_left, 8) << 1;
+    captures_right = side::forward(captures_right, 8) >> 1;
+
+    // keep the pawns that are over an enemy piece
+    captures_left = captures_left.mask(capturable);
+    captures_right = captures_right.mask(capturable);
+
+    for (auto moves :
+        {&advances_single, &advances_double, &captures_left, &captures_right}) {
+        *moves = moves->mask(allowed);
     }
-}
 
-/**************************# Slider Move Generation #**************************/
+    // Split the moves reaching the last rank
+    bitboard promotions_single = advances_single.mask(side::last_rank);
+    bitboard promotions_left = captures_left.mask(side::last_rank);
+    bitboard promotions_right = captures_right.mask(side::last_rank);
 
-//
-void generation::generate_moves_rook(GenerationContext& context) {
-    auto& board = context.board;
+    advances_single = advances_single.exclude(side::last_rank);
+    captures_left = captures_left.exclude(side::last_rank);
+    captures_right = captures_right.exclude(side::last_rank);
 
-    bitboard rooks = board.allied(Piece::ROOKS);
-    rooks = rooks.exclude(context.pinned.absolute | context.pinned.partial);
+    for (auto moves :
+        {&advances_single, &advances_double, &captures_left, &captures_right}) {
+        *moves = moves->mask(context.targets[Piece::PAWNS]);
+    }
 
-    bitboard capturable = board.enemies();
-    bitboard blockers = board.all();
+    if (!context.promotions) {
+        promotions_single = promotions_left = promotions_right = 0;
+    }
 
-    for (; rooks != 0; rooks ^= rooks.LSB()) {
-        square index = std::countr_zero((bitboard_t)rooks);
+    if (context.counting()) {
+        auto count = [](bitboard moves) {
+            return std::popcount((bitboard_t)moves);
+        };
 
-        bitboard moves = magic::rooks::get_avail_moves(blockers, index);
-        moves = moves.exclude(blockers ^ capturable);
-        moves = moves.mask(context.allowed_squares);
+        context.counted += count(advances_single) + count(advances_double) +
+            count(captures_left) + count(captures_right);
 
-        bitboard captures = moves.mask(capturable);
+        // one move for each piece a pawn can promote to
+        context.counted += 4 * (count(promotions_single) +
+                                   count(promotions_left) +
+                                   count(promotions_right));
+        return;
+    }
+
+    auto promote = [&](square from, square to, bool capture) {
+        for (Piece promotion : {Piece::QUEENS, Piece::ROOKS, Piece::BISHOPS,
+                 Piece::KNIGHTS}) {
+            context.add(Move::promote(from, to, promotion, capture));
+        }
+    };
+
+    for (; advances_single != 0; advances_single ^= advances_single.LSB()) {
+        square index = std::countr_zero((bitboard_t)advances_single);
 
-        context.bulk(Piece::ROOKS, index, moves, captures);
+        context.add(Move(side::behind(index), index));
     }
 
-    if (board.allied(Piece::KINGS) == 0) return;
+    for (; advances_double != 0; advances_double ^= advances_double.LSB()) {
+        square index = std::countr_zero((bitboard_t)advances_double);
 
-    if (context.in_check) return;
+        context.add(Move(side::behind(index, 2), index, Move::DOUBLE_PUSH));
+    }
 
-    bitboard pinned_partially = context.pinned.partial.mask(board.rooks);
+    for (; captures_left != 0; captures_left ^= captures_left.LSB()) {
+        square index = std::countr_zero((bitboard_t)captures_left);
 
-    square iking = std::countr_zero((bitboard_t)board.allied(Piece::KINGS));
-    bitboard king_slider = magic::rooks::get_slider(iking);
+        context.add(Move(side::behind(index).right(), index, Move::CAPTURE));
+    }
 
-    for (; pinned_partially != 0; pinned_partially ^= pinned_partially.LSB()) {
-        square index = std::countr_zero((bitboard_t)pinned_partially);
+    for (; captures_right != 0; captures_right ^= captures_right.LSB()) {
+        square index = std::countr_zero((bitboard_t)captures_right);
 
-        bitboard moves = magic::rooks::get_avail_moves(blockers, index);
-        moves = moves.mask(king_slider);
+        context.add(Move(side::behind(index).left(), index, Move::CAPTURE));
+    }
 
-        bitboard captures = moves.mask(capturable);
+    for (; promotions_single != 0;
+        promotions_single ^= promotions_single.LSB()) {
+        square index = std::countr_zero((bitboard_t)promotions_single);
+
+        promote(side::behind(index), index, false);
+    }
+
+    for (; promotions_left != 0; promotions_left ^= promotions_left.LSB()) {
+        square index = std::countr_zero((bitboard_t)promotions_left);
 
-        context.bulk(Piece::ROOKS, index, moves, captures);
+        promote(side::behind(index).right(), index, true);
+    }
+
+    for (; promotions_right != 0; promotions_right ^= promotions_right.LSB()) {
+        square index = std::countr_zero((bitboard_t)promotions_right);
+
+        promote(side::behind(index).left(), index, true);
     }
 }
 
-void generation::generate_moves_bishop(GenerationContext& context) {
+/*
+ * Generates the en passant captures of a set of pawns.
+ *
+ * Both pawns leave the board at once, so instead of using the pins
+ * the position after the capture is checked for discovered attacks.
+ */
+template <color_t us>
+static void generate_moves_pawn_en_passant(
+    generation::GenerationContext& context, bitboard pawns) {
+    namespace magic = generation::magic;
+    using side = Side<us>;
+
     auto& board = context.board;
 
-    bitboard bishops = board.allied(Piece::BISHOPS);
-    bishops = bishops.exclude(context.pinned.absolute | context.pinned.partial);
+    square target = board.en_passant_target_square;
 
-    bitboard capturable = board.enemies();
-    bitboard blockers = board.all();
+    if (target == square::out_of_bounds) return;
 
-    for (; bishops != 0; bishops ^= bishops.LSB()) {
-        square index = std::countr_zero((bitboard_t)bishops);
+    if (!context.targets[Piece::PAWNS][target]) return;
 
-        bitboard moves = magic::bishops::get_avail_moves(blockers, index);
-        moves = moves.exclude(blockers ^ capturable);
-        moves = moves.mask(context.allowed_squares);
+    square captured = side::behind(target);
 
-        bitboard captures = moves.mask(capturable);
+    // the capture has to block the check or take the checking pawn
+    if (!context.allowed_squares[target] && !context.allowed_squares[captured])
+        return;
 
-        context.bulk(Piece::BISHOPS, index, moves, captures);
-    }
+    // allied pawns are where an enemy pawn on the target would attack
+    bitboard attackers =
+        Side<side::them>::pawn_attacks(target.bb()).mask(pawns);
 
-    if (board.allied(Piece::KINGS) == 0) return;
+    bitboard king = board.pieces_of(us, Piece::KINGS);
 
-    if (context.in_check) return;
+    for (; attackers != 0; attackers ^= attackers.LSB()) {
+        square from = std::countr_zero((bitboard_t)attackers);
 
-    bitboard pinned_partially = context.pinned.partial.mask(board.bishops);
+        if (king != 0) {
+            square iking = std::countr_zero((bitboard_t)king);
 
-    square iking = std::countr_zero((bitboard_t)board.allied(Piece::KINGS));
-    bitboard king_slider = magic::bishops::get_slider(iking);
+            bitboard blockers = board.all() ^ from.bb() ^ captured.bb();
+            blockers |= target.bb();
 
-    for (; pinned_partially != 0; pinned_partially ^= pinned_partially.LSB()) {
-        square index = std::countr_zero((bitboard_t)pinned_partially);
+            bitboard enemies = board.colors[side::them];
 
-        bitboard moves = magic::bishops::get_avail_moves(blockers, index);
-        moves = moves.mask(king_slider);
+            bitboard discovered =
+                magic::bishops::get_avail_moves(blockers, iking)
+                    .mask(enemies.mask(board.bishops | board.queens)) |
+                magic::rooks::get_avail_moves(blockers, iking)
+                    .mask(enemies.mask(board.rooks | board.queens));
 
-        bitboard captures = moves.mask(capturable);
+            if (discovered != 0) continue;
+        }
 
-        context.bulk(Piece::BISHOPS, index, moves, captures);
+        context.add(Move(from, target, Move::EN_PASSANT));
     }
 }
 
-void generation::generate_moves_queen(GenerationContext& context) {
+//
+template <color_t us>
+void generation::generate_moves_pawn(GenerationContext& context) {
     auto& board = context.board;
 
-    bitboard queens = board.allied(Piece::QUEENS);
-    queens = queens.exclude(context.pinned.absolute | context.pinned.partial);
+    bitboard pawns = board.pieces_of(us, Piece::PAWNS).mask(context.movable);
 
-    bitboard capturable = board.enemies();
-    bitboard blockers = board.all();
+    generate_moves_pawn_en_passant<us>(context, pawns);
 
-    for (; queens != 0; queens ^= queens.LSB()) {
-        square index = std::countr_zero((bitboard_t)queens);
+    bitboard pawns_pinned = pawns.mask(context.pinned.absolute);
 
-        bitboard moves =  //
-            magic::rooks::get_avail_moves(blockers, index) |
-            magic::rooks::get_avail_moves(blockers, index);
+    // pawns that are not pinned move all together
+    generate_moves_pawn_set<us>(
+        context, pawns ^ pawns_pinned, bitboard::masks::fullboard);
 
-        moves = moves.exclude(blockers ^ capturable);
-        moves = moves.mask(context.allowed_squares);
+    if (pawns_pinned == 0) return;
 
-        bitboard captures = moves.mask(capturable);
+    square iking =
+        std::countr_zero((bitboard_t)board.pieces_of(us, Piece::KINGS));
 
-        context.bulk(Piece::QUEENS, index, moves, captures);
-    }
+    // pinned pawns can only move along the pin
+    for (; pawns_pinned != 0; pawns_pinned ^= pawns_pinned.LSB()) {
+        square index = std::countr_zero((bitboard_t)pawns_pinned);
 
-    if (board.allied(Piece::KINGS) == 0) return;
+        generate_moves_pawn_set<us>(
+            context, index.bb(), line_squares[iking][index]);
+    }
+}
 
-    if (context.in_check) return;
+/**************************# Knight Move Generation #**************************/
 
-    square iking = std::countr_zero((bitboard_t)board.allied(Piece::KINGS));
+//
+void generation::generate_moves_knight(GenerationContext& context) {
+    auto& board = context.board;
 
-    bitboard pins_diagonal = context.pinned.partial.mask(board.queens);
-    pins_diagonal = pins_diagonal.mask(magic::bishops::get_slider(iking));
+    bitboard knights = board.allied(Piece::KNIGHTS).mask(context.movable);
+    knights = knights.exclude(context.pinned.absolute);
 
-    bitboard king_slider = magic::bishops::get_slider(iking);
+    bitboard capturable = board.enemies();
+    bitboard blockers = board.allies();
 
-    for (; pins_diagonal != 0; pins_diagonal ^= pins_diagonal.LSB()) {
-        square index = std::countr_zero((bitboard_t)pins_diagonal);
+    for (; knights != 0; knights ^= knights.LSB()) {
+        square index = std::countr_zero((bitboard_t)knights);
 
-        bitboard moves =
-            magic::bishops::get_avail_moves(blockers, index).mask(king_slider);
+        bitboard moves = knights_moves[index].exclude(blockers);
+        moves = moves.mask(context.allowed_squares);
+        moves = moves.mask(context.targets[Piece::KNIGHTS]);
+        context.bulk(index, moves, capturable);
+    }
+}
 
-        bitboard captures = moves.mask(capturable);
+/**************************# Slider Move Generation #**************************/
 
-        context.bulk(Piece::QUEENS, index, moves, captures);
+/*
+ * Attacks of a slider type, resolved at compile time.
+ */
+template <piece_t slider>
+static inline bitboard slider_attacks(bitboard blockers, square index) {
+    namespace magic = generation::magic;
+
+    if constexpr (slider == Piece::ROOKS) {
+        return magic::rooks::get_avail_moves(blockers, index);
+    } else if constexpr (slider == Piece::BISHOPS) {
+        return magic::bishops::get_avail_moves(blockers, index);
+    } else {
+        static_assert(slider == Piece::QUEENS);
+
+        return magic::rooks::get_avail_moves(blockers, index) |
+            magic::bishops::get_avail_moves(blockers, index);
     }
+}
+
+/*
+ * Generates the moves of the rooks, bishops or queens.
+ *
+ * Pieces pinned along a line they can move on
+ * slide along the pin, unless in check.
+ */
+template <piece_t slider>
+void generation::generate_moves_slider(GenerationContext& context) {
+    auto& board = context.board;
 
-    bitboard pins_straight = context.pinned.partial.mask(board.queens);
-    pins_straight = pins_straight.mask(magic::rooks::get_slider(iking));
+    bitboard sliders = board.allied(slider).mask(context.movable);
+    bitboard pinned_partially = context.pinned.partial.mask(sliders);
 
-    king_slider = magic::rooks::get_slider(iking);
+    sliders = sliders.exclude(context.pinned.absolute | context.pinned.partial);
 
-    for (; pins_straight != 0; pins_straight ^= pins_straight.LSB()) {
-        square index = std::countr_zero((bitboard_t)pins_straight);
+    bitboard capturable = board.enemies();
+    bitboard blockers = board.all();
 
-        bitboard moves =
-            magic::rooks::get_avail_moves(blockers, index).mask(king_slider);
+    bitboard targets = context.targets[slider].exclude(board.allies());
+
+    for (; sliders != 0; sliders ^= sliders.LSB()) {
+        square index = std::countr_zero((bitboard_t)sliders);
+
+        bitboard moves = slider_attacks<slider>(blockers, index);
+        moves = moves.mask(context.allowed_squares);
+        moves = moves.mask(targets);
 
         bitboard captures = moves.mask(capturable);
 
-        context.bulk(Piece::QUEENS, index, moves, captures);
+        context.bulk(index, moves, captures);
     }
-}
 
-/***************************# King Move Generation #***************************/
+    if (pinned_partially == 0) return;
 
-//
-consteval std::array<bitboard, 64> intialize_king_table() {
-    std::array<bitboard, 64> moves = {0};
+    if (context.in_check) return;
 
-    for (square index = 0; index < 64; ++index) {
-        uint8_t row = index.row();
-        uint8_t column = index.column();
+    square iking = std::countr_zero((bitboard_t)board.allied(Piece::KINGS));
 
-        auto move_set = [&](int row, int col) {
-            if (row >= 0 && row < 8 && col >= 0 && col < 8)
-                moves[index] |= square::at(row, col).bb();
-        };
+    for (; pinned_partially != 0; pinned_partially ^= pinned_partially.LSB()) {
+        square index = std::countr_zero((bitboard_t)pinned_partially);
 
-        move_set(row + 1, column + 1);
-        move_set(row + 1, column);
-        move_set(row + 1, column - 1);
+        bitboard moves = slider_attacks<slider>(blockers, index);
+        moves = moves.mask(line_squares[iking][index]);
+        moves = moves.mask(targets);
 
-        move_set(row, column + 1);
-        move_set(row, column - 1);
+        bitboard captures = moves.mask(capturable);
 
-        move_set(row - 1, column + 1);
-        move_set(row - 1, column);
-        move_set(row - 1, column - 1);
+        context.bulk(index, moves, captures);
     }
-
-    return moves;
 }
 
-constexpr auto king_moves = intialize_king_table();
+/***************************# King Move Generation #***************************/
 
+//
+template <color_t us>
 void generation::generate_moves_king(GenerationContext& context) {
+    using side = Side<us>;
+
     auto& board = context.board;
 
-    bitboard king = board.allied(Piece::KINGS);
+    bitboard king = board.pieces_of(us, Piece::KINGS).mask(context.movable);
 
     // some test positions don't have a king
     if (!king) return;
 
-    bitboard capturable = board.enemies();
-    bitboard blockers = board.allies();
+    bitboard capturable = board.colors[side::them];
+    bitboard blockers = board.colors[us];
+    bitboard targets = context.targets[Piece::KINGS];
 
     square index = std::countr_zero((bitboard_t)king);
 
     bitboard moves =
         king_moves[index].exclude(blockers | context.attacked_squares);
+    moves = moves.mask(targets);
+
     bitboard captures = moves.mask(capturable);
 
-    context.bulk(Piece::KINGS, index, moves, captures);
+    context.bulk(index, moves, captures);
 
     if (context.in_check) return;
 
-    bitboard left_blockers;
-    left_blockers = bitboard::masks::file(1) | bitboard::masks::file(2);
-    left_blockers &= board.active_color ? bitboard::masks::rank(0)
-                                        : bitboard::masks::rank(7);
-    left_blockers &= blockers | context.attacked_squares;
+    // left is the queen side (a file), right is the king side (h file)
 
-    bitboard left_rook = board.allied(Piece::ROOKS);
-    left_rook &= bitboard::masks::file(0);
-    left_rook &= board.active_color ? bitboard::masks::rank(0)
-                                    : bitboard::masks::rank(7);
+    constexpr uint8_t row = us ? 0 : 7;
 
-    if (board.get_castling_left() && left_blockers == 0 & left_rook != 0) {
-        Move& m = context.next();
+    constexpr square king_start = square::at(row, 3);
+    constexpr square left_corner = square::at(row, 7);
+    constexpr square right_corner = square::at(row, 0);
 
-        m.moved = Piece::KINGS;
-        m.from = index;
-        m.to = index + 2;
+    constexpr bitboard left_path = between_squares[king_start][left_corner];
+    constexpr bitboard left_safe =
+        between_squares[king_start][king_start.left(3)];
+    constexpr bitboard left_rook = left_corner.bb();
 
-        m.castle = true;
-    }
+    constexpr bitboard right_path = between_squares[king_start][right_corner];
+    constexpr bitboard right_rook = right_corner.bb();
 
-    bitboard right_blockers;
-    right_blockers = bitboard::masks::file(6) | bitboard::masks::file(5) |
-        bitboard::masks::file(4);
-    right_blockers &= board.active_color ? bitboard::masks::rank(0)
-                                         : bitboard::masks::rank(7);
+    auto castling = board.castling_availability;
 
-    bitboard right_rook = board.allied(Piece::ROOKS);
-    right_rook &= bitboard::masks::file(7);
-    right_rook &= board.active_color ? bitboard::masks::rank(0)
-                                     : bitboard::masks::rank(7);
+    bool can_left = us ? castling.white_left : castling.black_left;
+    bool can_right = us ? castling.white_right : castling.black_right;
 
-    if (board.get_castling_right() && right_blockers == 0 && right_rook != 0) {
-        Move& m = context.next();
+    bitboard rooks = board.pieces_of(us, Piece::ROOKS);
 
-        m.moved = Piece::KINGS;
-        m.from = index;
-        m.to = index - 2;
+    if (can_left && targets[index + 2] && left_path.mask(board.all()) == 0 &&
+        left_safe.mask(context.attacked_squares) == 0 &&
+        left_rook.mask(rooks) != 0) {
+        context.add(Move(index, index + 2, Move::CASTLE));
+    }
 
-        m.castle = true;
+    if (can_right && targets[index - 2] &&
+        right_path.mask(board.all() | context.attacked_squares) == 0 &&
+        right_rook.mask(rooks) != 0) {
+        context.add(Move(index, index - 2, Move::CASTLE));
     }
 }
 
 /***********************# Context Bitboards Generation #***********************/
 
 /*
- * Sets a bitboard of squares that are attacked by the enemy pieces.
+ * Returns a bitboard of squares that are attacked by the enemies of `us`.
+ *
+ * The king of `us` is not a blocker,
+ * so squares behind it along a checking ray count as attacked.
  */
-void generation::get_bitboard_squares_attacked(
-    GenerationContext& context, bitboard& attacked_squares) {
-    auto board = context.board;
+template <color_t us>
+bitboard generation::get_bitboard_squares_attacked(const Board& board) {
+    using side = Side<us>;
+
+    bitboard attacked_squares = 0;
 
+    bitboard enemies = board.colors[side::them];
 
     struct {
         bitboard diagonal_sliders;
@@ -537,15 +914,12 @@ void generation::get_bitboard_squares_attacked(
         bitboard knights;
     } attackers;
 
-    attackers.diagonal_sliders =
-        board.enemies().mask(board.bishops | board.queens);
+    attackers.diagonal_sliders = enemies.mask(board.bishops | board.queens);
+    attackers.straight_sliders = enemies.mask(board.rooks | board.queens);
+    attackers.knights = enemies.mask(board.knights);
 
-    attackers.straight_sliders =
-        board.enemies().mask(board.rooks | board.queens);
-
-    attackers.knights = board.enemy(Piece::KNIGHTS);
-
-    bitboard blockers = board.all().exclude(board.allied(Piece::KINGS));
+    bitboard blockers =
+        board.all().exclude(board.pieces_of(us, Piece::KINGS));
 
     for (; attackers.diagonal_sliders != 0;
         attackers.diagonal_sliders ^= attackers.diagonal_sliders.LSB()) {
@@ -568,213 +942,211 @@ void generation::get_bitboard_squares_attacked(
         attacked_squares |= knights_moves[index];
     }
 
-    bitboard pawns = board.enemy(Piece::PAWNS);
-
-    // left pawn attacks
-    attacked_squares |=  //
-        pawns
-            .exclude(bitboard::masks::file(7))  //
-            .forward(!board.active_color, 8)    //
-        << 1;
+    attacked_squares |=
+        Side<side::them>::pawn_attacks(enemies.mask(board.pawns));
 
-    // right pawn attacks
-    attacked_squares |=  //
-        pawns
-            .exclude(bitboard::masks::file(0))  //
-            .forward(!board.active_color, 8)    //
-        >> 1;
+    bitboard enemy_king = enemies.mask(board.kings);
 
-    if (board.enemy(Piece::KINGS) != 0)
+    if (enemy_king != 0)
         attacked_squares |=
-            king_moves[std::countr_zero((bitboard_t)board.enemy(Piece::KINGS))];
+            king_moves[std::countr_zero((bitboard_t)enemy_king)];
 
+    return attacked_squares;
 }
 
-/*
- * Sets bitboards of pieces of pieces that
- * are between a the king and an enemy slider.
- *
- * `absolute` contains pieces that cannot move at all.
- * `partial`  contains pieces that can move along the pin.
- */
-void generation::get_bitboard_pieces_pinned(
-    GenerationContext& context, bitboard& absolute, bitboard& partial) {
-    auto& board = context.board;
+bitboard generation::get_bitboard_squares_attacked(const Board& board) {
+    if (board.active_color.isWhite())
+        return get_bitboard_squares_attacked<Color::WHITE>(board);
 
-    if (!board.allied(Piece::KINGS)) return;
-
-    bitboard pinned = 0;
+    return get_bitboard_squares_attacked<Color::BLACK>(board);
+}
 
-    bitboard king = board.allied(Piece::KINGS);
+/*
+ * Returns a bitboard of the enemy pieces giving check to the king of `us`.
+ */
+template <color_t us>
+bitboard generation::get_bitboard_checkers(const Board& board) {
+    using side = Side<us>;
 
-    bitboard blockers = board.all();
+    bitboard king = board.pieces_of(us, Piece::KINGS);
 
-    bitboard candidates;
-    bitboard pinners;
+    // some test positions don't have a king
+    if (!king) return 0;
 
     square iking = std::countr_zero((bitboard_t)king);
 
-    // get the pieces that are block the king
+    bitboard blockers = board.all();
+    bitboard enemies = board.colors[side::them];
 
-    candidates =
-        magic::bishops::get_avail_moves(blockers, iking).mask(board.allies());
-    candidates |=
-        magic::rooks::get_avail_moves(blockers, iking).mask(board.allies());
+    bitboard checkers;
 
-    bitboard discovered = blockers.exclude(candidates);
+    checkers = knights_moves[iking].mask(enemies.mask(board.knights));
 
-    // get the sliders that were discovered
+    checkers |= side::pawn_attacks(king).mask(enemies.mask(board.pawns));
 
-    pinners = magic::bishops::get_avail_moves(discovered, iking)
-                  .mask(board.enemies())
-                  .mask(board.bishops | board.queens);
+    checkers |= magic::bishops::get_avail_moves(blockers, iking)
+                    .mask(enemies)
+                    .mask(board.bishops | board.queens);
 
-    pinners |= magic::rooks::get_avail_moves(discovered, iking)
-                   .mask(board.enemies())
-                   .mask(board.rooks | board.queens);
+    checkers |= magic::rooks::get_avail_moves(blockers, iking)
+                    .mask(enemies)
+                    .mask(board.rooks | board.queens);
 
-    struct {
-        bitboard before;
-        bitboard after;
-    } side;
-
-    side.before = king - 1;
-    side.after = ~side.before;
-
-    union {
-        struct {
-            bitboard_t vertical;
-            bitboard_t horizontal;
-            bitboard_t diagonal;
-            bitboard_t rdiagonal;
-        };
-        bitboard all[4] = {0};
-    } sliders;
+    return checkers;
+}
 
-    sliders.diagonal = bitboard::masks::diagonal_at(iking);
-    sliders.rdiagonal = bitboard::masks::rev_diagonal_at(iking);
-    sliders.vertical = bitboard::masks::file(iking.column());
-    sliders.horizontal = bitboard::masks::rank(iking.row());
+bitboard generation::get_bitboard_checkers(const Board& board) {
+    if (board.active_color.isWhite())
+        return get_bitboard_checkers<Color::WHITE>(board);
 
-    for (const bitboard& slider : sliders.all) {
-        bitboard curr_mask;
+    return get_bitboard_checkers<Color::BLACK>(board);
+}
 
-        curr_mask = slider.mask(side.before);
+/*
+ * Returns the pieces of both colors attacking `target`,
+ * as if only the pieces in `occupancy` were on the board.
+ *
+ * Sliders are looked up with `occupancy` as the blockers,
+ * so removing a piece reveals the ones behind it (x-rays).
+ */
+bitboard generation::attackers_to(
+    const Board& board, square target, bitboard occupancy) {
+    namespace magic = generation::magic;
 
-        pinned |= candidates
-                      .mask(curr_mask)  //
-                      .mask(-(!!pinners.mask(curr_mask)));
+    bitboard attackers;
 
-        curr_mask = slider.mask(side.after);
+    attackers = knights_moves[target].mask(board.knights);
+    attackers |= king_moves[target].mask(board.kings);
 
-        pinned |= candidates
-                      .mask(curr_mask)  //
-                      .mask(-(!!pinners.mask(curr_mask)));
-    }
+    // a pawn attacks the squares a pawn of the other color is attacked from
+    attackers |= Side<Color::BLACK>::pawn_attacks(target.bb())
+                     .mask(board.pieces_of(Color::WHITE, Piece::PAWNS));
+    attackers |= Side<Color::WHITE>::pawn_attacks(target.bb())
+                     .mask(board.pieces_of(Color::BLACK, Piece::PAWNS));
 
-    bitboard partial_pin = 0;
+    attackers |= magic::bishops::get_avail_moves(occupancy, target)
+                     .mask(board.bishops | board.queens);
+    attackers |= magic::rooks::get_avail_moves(occupancy, target)
+                     .mask(board.rooks | board.queens);
 
-    partial = pinned.mask(board.queens);
+    return attackers.mask(occupancy);
+}
 
-    partial |=
-        pinned.mask(board.rooks).mask(sliders.vertical | sliders.horizontal);
+/*
+ * Sets the check and pin data of the side to move
+ * kept in the state of the board.
+ *
+ * Called by `Board::play` and FEN parsing once per position,
+ * `Board::unplay` restores it together with the rest of the state.
+ */
+template <color_t us>
+static void update_state(Board& board) {
+    namespace generation = core::generation;
 
-    partial |=
-        pinned.mask(board.bishops).mask(sliders.diagonal | sliders.rdiagonal);
+    board.king_danger = generation::get_bitboard_squares_attacked<us>(board);
+    board.checkers = generation::get_bitboard_checkers<us>(board);
+    board.pinned = generation::get_bitboard_pieces_pinned(board, us);
+}
 
-    absolute = pinned.exclude(partial);
-    partial = partial;
+void generation::update_state(Board& board) {
+    if (board.active_color.isWhite()) {
+        core::update_state<Color::WHITE>(board);
+    } else {
+        core::update_state<Color::BLACK>(board);
+    }
 }
 
 /*
- * Sets a bitboard of squares that allow a piece to block a check.
- * King moves are considered evasions not blocks.
- *
- * Returns `true` if the check can be blocked.
- * Returns `false` if only the king can evade the block.
+ * Returns a bitboard of the pieces of `color` that are
+ * the only piece between their king and an enemy slider.
  */
-bool generation::get_bitboard_check_blocks(
-    GenerationContext& context, bitboard& check_blocks) {
-    auto& board = context.board;
+bitboard generation::get_bitboard_pieces_pinned(
+    const Board& board, Color color) {
+    bitboard king = board.kings & board.colors[color];
 
-    // HANDLE EN PASSANT
+    if (!king) return 0;
 
-    bitboard king = board.allied(Piece::KINGS);
     square iking = std::countr_zero((bitboard_t)king);
 
-    struct {
-        bitboard knight;
-        bitboard diagonal;
-        bitboard straight;
-        bitboard pawn;
-    } check_pattern, checking_piece;
+    bitboard enemies = board.colors[!color];
 
-    check_pattern.knight = knights_moves[iking];
-    checking_piece.knight = check_pattern.knight & board.enemy(Piece::KNIGHTS);
+    // enemy sliders aligned with the king, ignoring allied pieces
+    bitboard pinners;
 
-    if (checking_piece.knight != 0) {
-        // Cannot block check
-        check_blocks = checking_piece.knight;
-        return true;  // NOTE: Can optimize the generation by detecting which
-                      // pieces can capture the knight directly.
-    }
+    pinners = magic::bishops::get_avail_moves(enemies, iking)
+                  .mask(enemies)
+                  .mask(board.bishops | board.queens);
+
+    pinners |= magic::rooks::get_avail_moves(enemies, iking)
+                   .mask(enemies)
+                   .mask(board.rooks | board.queens);
 
-    // GET ATTACKING SLIDER
-    check_pattern.diagonal =
-        magic::bishops::get_avail_moves(board.all(), iking);
-    checking_piece.diagonal =
-        board.enemies().mask(board.bishops | board.queens);
+    bitboard pinned = 0;
 
-    check_pattern.straight =
-        magic::bishops::get_avail_moves(board.all(), iking);
-    checking_piece.straight = board.enemies().mask(board.rooks | board.queens);
+    for (; pinners != 0; pinners ^= pinners.LSB()) {
+        square index = std::countr_zero((bitboard_t)pinners);
 
-    check_pattern.pawn =
-        king.exclude(bitboard::masks::file(0)).forward(board.active_color, 7);
-    check_pattern.pawn |=
-        king.exclude(bitboard::masks::file(7)).forward(board.active_color, 9);
+        bitboard blockers = between_squares[iking][index].mask(board.all());
 
-    checking_piece.pawn = board.enemy(Piece::PAWNS).mask(check_pattern.pawn);
+        if (std::popcount((bitboard_t)blockers) == 1) {
+            pinned |= blockers.mask(board.colors[color]);
+        }
+    }
 
-    bitboard all_attackers =
-        checking_piece.diagonal | checking_piece.straight | checking_piece.pawn;
+    return pinned;
+}
 
-    if (std::popcount((bitboard_t)all_attackers) != 1) {
+/*
+ * Sets a bitboard of squares that allow a piece to block a check,
+ * the checking piece included.
+ * King moves are considered evasions not blocks.
+ *
+ * Returns `true` if the check can be blocked.
+ * Returns `false` if only the king can evade the block.
+ */
+bool generation::get_bitboard_check_blocks(
+    const Board& board, bitboard& check_blocks) {
+    if (std::popcount((bitboard_t)board.checkers) != 1) {
         // Cannot block check
         check_blocks = 0;
         return false;
     }
 
-    if (0 != checking_piece.pawn) {
-        check_blocks = checking_piece.pawn;
-        return true;
-    }
-
-    // GET RAY TO CHECKING PIECE
-
-    bitboard checking_ray;
+    square iking = std::countr_zero((bitboard_t)board.allied(Piece::KINGS));
+    square checker = std::countr_zero((bitboard_t)board.checkers);
 
-    if (0 != checking_piece.diagonal) {
-        square attacker = std::countr_zero((bitboard_t)checking_piece.diagonal);
+    // Knights and pawns can only be captured,
+    // sliders can also be blocked
+    check_blocks = board.checkers | between_squares[iking][checker];
 
-        checking_ray = check_pattern.diagonal.mask(
-            magic::bishops::get_avail_moves(board.all(), attacker));
+    return true;
+}
 
-        checking_ray |= checking_piece.diagonal;
-    }
+/*************************# Explicit Instantiations #**************************/
 
-    if (0 != checking_piece.straight) {
-        square attacker = std::countr_zero((bitboard_t)checking_piece.straight);
+template void generation::generate_moves_pawn<Color::WHITE>(
+    GenerationContext&);
+template void generation::generate_moves_pawn<Color::BLACK>(
+    GenerationContext&);
 
-        checking_ray = check_pattern.straight.mask(
-            magic::rooks::get_avail_moves(board.all(), attacker));
+template void generation::generate_moves_slider<Piece::ROOKS>(
+    GenerationContext&);
+template void generation::generate_moves_slider<Piece::BISHOPS>(
+    GenerationContext&);
+template void generation::generate_moves_slider<Piece::QUEENS>(
+    GenerationContext&);
 
-        checking_ray |= checking_piece.straight;
-    }
+template void generation::generate_moves_king<Color::WHITE>(
+    GenerationContext&);
+template void generation::generate_moves_king<Color::BLACK>(
+    GenerationContext&);
 
-    return true;
+template bitboard generation::get_bitboard_squares_attacked<Color::WHITE>(
+    const Board&);
+template bitboard generation::get_bitboard_squares_attacked<Color::BLACK>(
+    const Board&);
 
-    // TODO: GENERATE MOVES ONLY ON THE CHECKING RAY (DONE I THINK)
-}
+template bitboard generation::get_bitboard_checkers<Color::WHITE>(const Board&);
+template bitboard generation::get_bitboard_checkers<Color::BLACK>(const Board&);
 
 }  // namespace core
@@ -2,21 +2,71 @@
 
 #include <core/types.hpp>
 
+#include <algorithm>
 #include <array>
+#include <cassert>
 #include <vector>
 
 namespace core::generation {
 
 constexpr uint8_t max_moves = 218;
 
-class GenerationContext {
+/*
+ * Fixed capacity list of moves.
+ *
+ * Lives on the stack (or inside any caller-owned storage)
+ * so generating moves never touches the allocator.
+ * Can be cleared and reused between calls.
+ */
+class MoveList {
    private:
     std::array<Move, max_moves> moves;
-    uint8_t nxt = 0;
+    uint8_t count = 0;
+
+   public:
+    using iterator = Move*;
+    using const_iterator = const Move*;
+
+    inline void push_back(const Move& move) {
+        assert(count < max_moves);
+        moves[count++] = move;
+    }
+
+    inline void clear() { count = 0; }
+
+    inline uint8_t size() const { return count; }
+    inline bool empty() const { return count == 0; }
+
+    inline Move& operator[](uint8_t index) { return moves[index]; }
+    inline const Move& operator[](uint8_t index) const { return moves[index]; }
+
+    inline iterator begin() { return moves.data(); }
+    inline iterator end() { return moves.data() + count; }
 
+    inline const_iterator begin() const { return moves.data(); }
+    inline const_iterator end() const { return moves.data() + count; }
+
+    template <typename Compare>
+    inline void sort(Compare compare) {
+        std::sort(begin(), end(), compare);
+    }
+};
+
+/*
+ * Attack and pin data of a position,
+ * read from the board on construction and shared by every generation stage.
+ */
+class GenerationContext {
    public:
     const Board& board;
 
+    // list receiving the moves of the current stage,
+    // when null the moves are only counted
+    MoveList* moves = nullptr;
+
+    // moves found while counting
+    uint64_t counted = 0;
+
     struct {
         bitboard absolute = 0, partial = 0;
     } pinned;
@@ -25,35 +75,82 @@ class GenerationContext {
     bitboard allowed_squares = bitboard::masks::fullboard;
 
     bool in_check = false;
+    bool can_block_check = true;
+
+    // Filters of the current stage
+
+    // destination squares wanted for each piece
+    bitboard targets[6];
 
-    GenerationContext(const Board& board) : board(board) {}
+    // pieces allowed to move
+    bitboard movable = bitboard::masks::fullboard;
 
-    Move& next();
+    // generate promotions (regardless of `targets`)
+    bool promotions = true;
 
-    void bulk(Piece moved, square from, bitboard moves, bitboard capturable);
+    GenerationContext(const Board& board);
 
-    std::vector<Move> get_generated_moves();
+    inline bool counting() const { return moves == nullptr; }
+
+    inline void add(Move move) {
+        if (counting()) {
+            ++counted;
+            return;
+        }
+
+        moves->push_back(move);
+    }
+
+    inline void set_targets(bitboard squares) {
+        for (bitboard& target : targets) target = squares;
+    }
+
+    void bulk(square from, bitboard moves, bitboard capturable);
 };
 
 std::vector<Move> generate_moves(const Board& board);
 
+void generate_moves(const Board& board, MoveList& moves);
+
+uint64_t count_moves(const Board& board);
+
+// Generation stages, they append to `moves`
+
+void generate_captures(GenerationContext& context, MoveList& moves);
+
+void generate_quiets(GenerationContext& context, MoveList& moves);
+
+void generate_evasions(GenerationContext& context, MoveList& moves);
+
+void generate_quiet_checks(GenerationContext& context, MoveList& moves);
+
+// Piece generators, specialized on the side to move or the slider type
+
+template <color_t us>
 void generate_moves_pawn(GenerationContext& context);
 
 void generate_moves_knight(GenerationContext& context);
 
-void generate_moves_rook(GenerationContext& context);
+template <piece_t slider>
+void generate_moves_slider(GenerationContext& context);
 
-void generate_moves_bishop(GenerationContext& context);
+template <color_t us>
+void generate_moves_king(GenerationContext& context);
 
-void generate_moves_queen(GenerationContext& context);
+void update_state(Board& board);
 
-void generate_moves_king(GenerationContext& context);
+template <color_t us>
+bitboard get_bitboard_squares_attacked(const Board& board);
+bitboard get_bitboard_squares_attacked(const Board& board);
+
+template <color_t us>
+bitboard get_bitboard_checkers(const Board& board);
+bitboard get_bitboard_checkers(const Board& board);
 
-void get_bitboard_squares_attacked(GenerationContext& context, bitboard& attacked);
+bitboard get_bitboard_pieces_pinned(const Board& board, Color color);
 
-void get_bitboard_pieces_pinned(
-    GenerationContext& context, bitboard& absolute, bitboard& partial);
+bitboard attackers_to(const Board& board, square target, bitboard occupancy);
 
-bool get_bitboard_check_blocks(GenerationContext& context, bitboard& check_blocks);
+bool get_bitboard_check_blocks(const Board& board, bitboard& check_blocks);
 
 }  // namespace core::generation
@@ -0,0 +1,61 @@
+#include "history.hpp"
+
+#include <algorithm>
+
+void core::History::play(Board& board, Move move) {
+    entries.push_back({board.play(move), move});
+}
+
+void core::History::unplay(Board& board) {
+    assert(!entries.empty());
+
+    const Entry& entry = entries.back();
+
+    board.unplay(entry.move, entry.state);
+
+    entries.pop_back();
+}
+
+/*
+ * Returns how many earlier positions of the game are the same as the board.
+ *
+ * Captures and pawn moves reset the halfmove clock and cannot be undone,
+ * so only the last `halfmove_clock` plies are scanned,
+ * and only every other one since the side to move has to match.
+ * Two plies back can never match, both sides moved once since.
+ */
+int core::History::repetitions(const Board& board) const {
+    size_t count = entries.size();
+    size_t reversible = std::min<size_t>(board.halfmove_clock, count);
+
+    int found = 0;
+
+    for (size_t ply = 4; ply <= reversible; ply += 2) {
+        if (entries[count - ply].state.hash == board.hash) ++found;
+    }
+
+    return found;
+}
+
+/*
+ * Returns true if the position already happened,
+ * enough for a search to score it as a draw.
+ */
+bool core::History::is_repetition(const Board& board) const {
+    size_t count = entries.size();
+    size_t reversible = std::min<size_t>(board.halfmove_clock, count);
+
+    for (size_t ply = 4; ply <= reversible; ply += 2) {
+        if (entries[count - ply].state.hash == board.hash) return true;
+    }
+
+    return false;
+}
+
+bool core::History::is_threefold_repetition(const Board& board) const {
+    return repetitions(board) >= 2;
+}
+
+bool core::History::is_fifty_move_draw(const Board& board) const {
+    return board.halfmove_clock >= 100;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <core/types.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace core {
+
+/*
+ * Previous states of a game, kept alongside its `Board`.
+ *
+ * Reserves room for most games up front so playing moves
+ * rarely touches the allocator, longer games grow the storage.
+ * The board itself stays a small copyable value.
+ */
+class History {
+   public:
+    static constexpr size_t reserved_plies = 1024;
+
+    History() { entries.reserve(reserved_plies); }
+
+    // Plays a move on the board and keeps the state needed to undo it
+    void play(Board& board, Move move);
+
+    // Undoes the last move played through this history
+    void unplay(Board& board);
+
+    inline void clear() { entries.clear(); }
+
+    inline size_t size() const { return entries.size(); }
+    inline bool empty() const { return entries.empty(); }
+
+    inline Move last_move() const {
+        assert(!entries.empty());
+        return entries.back().move;
+    }
+
+    int repetitions(const Board& board) const;
+
+    bool is_repetition(const Board& board) const;
+    bool is_threefold_repetition(const Board& board) const;
+    bool is_fifty_move_draw(const Board& board) const;
+
+   private:
+    struct Entry {
+        // state before the move, its hash is the key of that position
+        Board::State state;
+        Move move;
+    };
+
+    std::vector<Entry> entries;
+};
+
+}  // namespace core
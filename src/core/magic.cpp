@@ -1,8 +1,17 @@
 #include <core/magic.hpp>
 
 #include <array>
-#include <cassert>
+#include <bit>
 #include <cstring>
+#include <span>
+
+// PEXT lookups and their table are only built when opted in
+#if defined(__x86_64__) && defined(CHESSY_PEXT)
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define MAGIC_HAS_PEXT
+#endif
 
 namespace core::generation::magic {
 
@@ -39,11 +48,14 @@ inline uint64_t rnd_composite_low() {
 }  // namespace rnd
 
 struct MagicEntry {
-    bitboard mask;
-    uint64_t magic;
-    uint8_t bits;
+    bitboard mask = 0;
+    uint64_t magic = 0;
+    uint8_t bits = 0;
 
-    constexpr uint16_t magic_index(bitboard blockers) {
+    // index of the first entry of the square in the shared attacks table
+    uint32_t offset = 0;
+
+    constexpr uint16_t magic_index(bitboard blockers) const {
         blockers &= mask;
         const uint64_t hash = blockers * magic;
 
@@ -53,41 +65,150 @@ struct MagicEntry {
     }
 };
 
-template <typename Derived, uint8_t Bits>
-struct MagicTable {
-    static constexpr uint8_t bits = Bits;
-    static MagicEntry entries[64];
+// Largest per square table, a rook on a corner has 12 relevant blockers
+constexpr uint16_t max_table_size = 1 << 12;
 
-    static constexpr bitboard table_size = bitboard::masks::at(Bits);
-    static std::array<bitboard, table_size> moves[64];
+// Rooks have 102400 entries and bishops 5248, checked below
+constexpr uint32_t attacks_size = 102400 + 5248;
 
-    static const std::array<uint64_t, 64> precalc_magics;
+// Attacks of every slider, square and blocker combination,
+// rooks first then bishops so both share one contiguous table
+struct SliderAttacks {
+    std::array<bitboard_t, attacks_size> magic;
 
-    static inline bitboard relevant_blockers(square index) {
+#ifdef MAGIC_HAS_PEXT
+    // Same layout but indexed by the blockers extracted with PEXT
+    std::array<bitboard_t, attacks_size> pext;
+#endif
+};
+
+template <typename Derived>
+struct MagicTable {
+    static inline constexpr bitboard relevant_blockers(square index) {
         return Derived::relevant_blockers(index);
     };
-    static inline bitboard slider(square index) {
+    static inline constexpr bitboard slider(square index) {
         return Derived::slider(index);
     }
 
-    static bitboard gen_moves(bitboard blockers, square index) {
-        return Derived::gen_moves(blockers, index);
+    /*
+     * Moves of a slider on `index`,
+     * walks every ray of `Derived::rays` up to the first blocker (inclusive).
+     *
+     * Works on plain integers as it is evaluated at compile time.
+     */
+    static constexpr bitboard_t walk_moves(bitboard_t blockers, int index) {
+        bitboard_t moves = 0;
+
+        for (auto [drow, dcol] : Derived::rays) {
+            int row = index / 8 + drow, col = index % 8 + dcol;
+
+            for (; row >= 0 && row < 8 && col >= 0 && col < 8;
+                row += drow, col += dcol) {
+                bitboard_t bit = bitboard_t(1) << (row * 8 + col);
+                moves |= bit;
+
+                if (blockers & bit) break;
+            }
+        }
+
+        return moves;
+    }
+
+    // Every square gets only as many index bits as it has relevant blockers
+    static constexpr uint8_t bits(square index) {
+        return std::popcount((bitboard_t)relevant_blockers(index));
     }
 
-    static bitboard get_moves(bitboard blockers, square index) {
-        auto rel_blockers = relevant_blockers(index).mask(blockers);
-        auto magic_index = entries[index].magic_index(rel_blockers);
+    // Number of entries used by all the squares
+    static constexpr uint32_t table_size() {
+        uint32_t size = 0;
 
-        return moves[index][magic_index];
+        for (square index = 0; index < 64; ++index)
+            size += 1 << MagicTable::bits(index);
+
+        return size;
+    }
+
+    /*
+     * Builds the entries of every square from its magic number,
+     * squares are laid out one after the other from `Derived::table_offset`.
+     */
+    static consteval std::array<MagicEntry, 64> make_entries(
+        const std::array<uint64_t, 64>& magics) {
+        std::array<MagicEntry, 64> entries;
+
+        uint32_t offset = Derived::table_offset;
+
+        for (square index = 0; index < 64; ++index) {
+            MagicEntry& entry = entries[index];
+
+            entry.bits = MagicTable::bits(index);
+            entry.magic = magics[index];
+            entry.mask = MagicTable::relevant_blockers(index);
+            entry.offset = offset;
+
+            offset += 1 << entry.bits;
+        }
+
+        return entries;
+    }
+
+    /*
+     * Writes the moves of every square and blocker combination
+     * into the magic indexed table, and the PEXT one if built.
+     *
+     * Blockers are enumerated in increasing order,
+     * which is the order of their PEXT indices.
+     *
+     * Fails to compile if the magic numbers produce a collision.
+     */
+    static constexpr void fill_attacks(
+        SliderAttacks& attacks, const std::array<MagicEntry, 64>& entries) {
+        constexpr uint64_t cleared_value = 0;
+
+        for (square index = 0; index < 64; ++index) {
+            // plain integers, wrappers are slow to evaluate at compile time
+            const bitboard_t mask = entries[index].mask;
+            const uint64_t magic = entries[index].magic;
+            const uint8_t shift = 64 - entries[index].bits;
+
+            bitboard_t* magic_table = &attacks.magic[entries[index].offset];
+#ifdef MAGIC_HAS_PEXT
+            bitboard_t* pext_table = &attacks.pext[entries[index].offset];
+#endif
+
+            bitboard_t blockers = 0;
+
+            do {
+                bitboard_t moves = MagicTable::walk_moves(blockers, index);
+
+                bitboard_t& slot = magic_table[(blockers * magic) >> shift];
+
+                if (slot != cleared_value && slot != moves)
+                    throw "magic number collision";
+
+                slot = moves;
+
+#ifdef MAGIC_HAS_PEXT
+                *pext_table++ = moves;
+#endif
+
+                // next combination of blockers
+                blockers = (blockers - mask) & mask;
+            } while (blockers != 0);
+        }
     }
 
     static MagicEntry search_magic(square index) {
         // Fill base entry data
         MagicEntry entry;
-        entry.bits = MagicTable::bits;
+        entry.bits = MagicTable::bits(index);
         entry.mask = MagicTable::relevant_blockers(index);
 
-        std::array<bitboard, MagicTable::table_size> table = {0};
+        const uint16_t table_size = 1 << entry.bits;
+
+        std::array<bitboard, max_table_size> table = {0};
 
         // Precalculate the moves bitboards for every blocker
 
@@ -95,8 +216,7 @@ struct MagicTable {
             bitboard blockers, moves;
         };
 
-        const uint16_t max_blockers_com = table.size();
-        std::array<Precalc, max_blockers_com> precalc;
+        std::array<Precalc, max_table_size> precalc;
 
         bitboard curr_blocker_mask = entry.mask;
         constexpr bitboard last_blo_com = 0;
@@ -106,7 +226,7 @@ struct MagicTable {
             // fill the precalculated entry
             precalc[blockers_count].blockers = curr_blocker_mask;
             precalc[blockers_count].moves =
-                MagicTable::gen_moves(curr_blocker_mask, index);
+                MagicTable::walk_moves(curr_blocker_mask, index);
 
             ++blockers_count;
 
@@ -122,14 +242,14 @@ struct MagicTable {
         while (true) {
             do {  // Find a suitable magic number
                 entry.magic = rnd::rnd_composite_low();
-            } while (std::popcount(entry.magic_index(entry.mask)) < 6);
+            } while (std::popcount((entry.mask * entry.magic) >> 56) < 6);
 
             // Clear table and try again
             std::memset((char*)table.data(), cleared_value,
                 table_size * sizeof(*table.data()));
 
             // Loop through all possible blockers configurations
-            for (Precalc pre : precalc) {
+            for (Precalc pre : std::span(precalc.data(), table_size)) {
                 uint16_t magic_index = entry.magic_index(pre.blockers);
 
                 if (table[magic_index] != cleared_value &&
@@ -153,324 +273,321 @@ struct MagicTable {
         return precalc_magics;
     }
 
-#ifndef MAGIC_STANDALONE
-    static void initialize() {
-        for (square index = 0; index < 64; ++index) {
-            MagicEntry& entry = MagicTable::entries[index];
+};
 
-            entry.bits = MagicTable::bits;
-            entry.magic = MagicTable::precalc_magics[index];
-            entry.mask = MagicTable::relevant_blockers(index);
+using masks = core::bitboard::masks;
 
-            constexpr bitboard last_blo_com = 0;
-            constexpr uint64_t cleared_value = 0;
+struct Rookst : public MagicTable<Rookst> {
+    // Rooks use the front of the shared attacks table
+    static constexpr uint32_t table_offset = 0;
 
-            for (bitboard curr_blocker_mask = entry.mask;;
-                curr_blocker_mask = (curr_blocker_mask - 1) & entry.mask) {
-                uint16_t magic_index = entry.magic_index(curr_blocker_mask);
+    // {row, column} steps
+    static constexpr int rays[4][2]{{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
 
-                bitboard moves =
-                    MagicTable::gen_moves(curr_blocker_mask, index);
+    static inline constexpr bitboard relevant_blockers(square index) {
+        constexpr bitboard rel_blockers_vertical =
+            masks::vertical & ~0x0100000000000001;
+        constexpr bitboard rel_blockers_horizontal = masks::horizontal & ~0x81;
 
-                assert(MagicTable::moves[index][magic_index] == cleared_value ||
-                    MagicTable::moves[index][magic_index] == moves);
+        // the rook itself is never a blocker
+        return bitboard((rel_blockers_vertical << index.column()) |
+            (rel_blockers_horizontal << (index.row() * 8)))
+            .exclude(masks::at(index));
+    }
 
-                MagicTable::moves[index][magic_index] = moves;
+    static inline constexpr bitboard slider(square index) {
+        return (masks::horizontal << (index.row() * 8)) ^
+            (masks::vertical << index.column());
+    }
+};
 
-                // check if we just filled
-                // the last combination of blockers
-                if (curr_blocker_mask == last_blo_com) break;
-            }
-        }
+struct Bishopst : public MagicTable<Bishopst> {
+    // Bishops are packed right after the rooks in the shared attacks table
+    static constexpr uint32_t table_offset = Rookst::table_size();
+
+    // {row, column} steps
+    static constexpr int rays[4][2]{{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+    static inline constexpr bitboard relevant_blockers(square index) {
+        return slider(index).exclude(masks::border);
     }
 
-   private:
-    inline static struct Initializer {
-        Initializer() { MagicTable::initialize(); }
-    } initializer;
-#endif
+    static inline constexpr bitboard slider(square index) {
+        return masks::diagonal_at(index) ^ masks::rev_diagonal_at(index);
+    }
 };
 
-// Define the static members outside the class template
-template <typename Derived, uint8_t Bits>
-MagicEntry MagicTable<Derived, Bits>::entries[64];
+// Generated using maggen binary
+constexpr std::array<uint64_t, 64> rook_magics = {
+    0x180004000681080UL,
+    0x2040001000402000UL,
+    0x1080200080081000UL,
+    0x1180050800300080UL,
+    0x1100021008010004UL,
+    0x8300022804000100UL,
+    0x1A00080200208401UL,
+    0x4080004C80023100UL,
+    0x420802040008000UL,
+    0x20404010002000UL,
+    0xE008801000842000UL,
+    0x200808010000800UL,
+    0x604E001022004508UL,
+    0x18800401800200UL,
+    0x7000808002000100UL,
+    0x42000C0100608AUL,
+    0x500208000804000UL,
+    0x400808040002002UL,
+    0x10002008002401UL,
+    0x10808010000802UL,
+    0x100050008001100UL,
+    0x4241010002080400UL,
+    0x4200040081020810UL,
+    0x10024A0000804904UL,
+    0x410800300204504UL,
+    0x80200880400080UL,
+    0x81A1104200260280UL,
+    0xA890100080080080UL,
+    0x6000600082090UL,
+    0x2000200040810UL,
+    0x11C100400010208UL,
+    0x8200004104UL,
+    0xC180002002400140UL,
+    0xA30002000404000UL,
+    0x8020080040401000UL,
+    0x4080210009001001UL,
+    0x401001085000800UL,
+    0xA00020080800400UL,
+    0x2002809040002D0UL,
+    0x40062000081UL,
+    0x5C0802040108008UL,
+    0x8050002000404002UL,
+    0x2000200010008080UL,
+    0x1002010010008UL,
+    0x4000110008010005UL,
+    0x1000204010008UL,
+    0x1004200110004UL,
+    0xC2082420013UL,
+    0x880022000400240UL,
+    0x420108040002080UL,
+    0x40A124020030100UL,
+    0x18040810008080UL,
+    0x3891004488005100UL,
+    0x800400020080UL,
+    0xA002000408810200UL,
+    0x10400508200UL,
+    0x4004504123060282UL,
+    0x81360A4020830012UL,
+    0x40884020010033UL,
+    0x8000050010002109UL,
+    0x4006002004081002UL,
+    0x2003000802040001UL,
+    0x1122100C8804UL,
+    0x88090048802412UL,
+};
 
-template <typename Derived, uint8_t Bits>
-std::array<bitboard, MagicTable<Derived, Bits>::table_size>
-    MagicTable<Derived, Bits>::moves[64] = {0};
+// Generated using maggen binary
+constexpr std::array<uint64_t, 64> bishop_magics = {
+    0x144841002020012UL,
+    0x1C42101401005021UL,
+    0x10404008A008410UL,
+    0x288084104004182UL,
+    0x1422021100800140UL,
+    0x1010822022201080UL,
+    0x804042A03300000UL,
+    0x1210202802082020UL,
+    0x80A02001010120UL,
+    0x4000092821004A00UL,
+    0x900100102003102UL,
+    0x4A01F08902082018UL,
+    0x6000640420820020UL,
+    0x10210160100008UL,
+    0x8C08421084100UL,
+    0x42420104210420UL,
+    0x10006204A12800UL,
+    0x1108020401280A22UL,
+    0x18005000242820UL,
+    0x408000082044000UL,
+    0x102800404A00060UL,
+    0x40800100A00100UL,
+    0x8001100400821048UL,
+    0x42000040740400UL,
+    0x4804048210200808UL,
+    0x10880030911506UL,
+    0x8801204E0C0100UL,
+    0x220060005C01040UL,
+    0x848014002006UL,
+    0x8680810242010080UL,
+    0x1511420000521000UL,
+    0x81020000420086UL,
+    0x20A1104000080800UL,
+    0x1010800210800UL,
+    0xC00A03001080180UL,
+    0x1000020080880082UL,
+    0x60201C200040208UL,
+    0x10004200004129UL,
+    0x4210C108A4C04UL,
+    0xA8039131010102UL,
+    0x1411040109000UL,
+    0x300882110000840UL,
+    0x2213002110040910UL,
+    0x938202011009810UL,
+    0x25204010C000201UL,
+    0xC0008080800900UL,
+    0x8811104001200UL,
+    0x801011101040200UL,
+    0xA81014802404001UL,
+    0x8006064108084030UL,
+    0x410082410201UL,
+    0x1200000504980010UL,
+    0x1000000803040000UL,
+    0xC80041002AA0002UL,
+    0x20980284840002UL,
+    0x4080845002822UL,
+    0x8000240404040260UL,
+    0x8051103080UL,
+    0x3411200020841055UL,
+    0x800080000420218UL,
+    0x31008101142D0400UL,
+    0x2000001010022820UL,
+    0x5050400801841081UL,
+    0x4204204200420080UL,
+};
 
-using masks = core::bitboard::masks;
+#ifndef MAGIC_STANDALONE
 
-struct Rookst : public MagicTable<Rookst, 12> {
-    static inline bitboard relevant_blockers(square index) {
-        static constexpr bitboard rel_blockers_vertical =
-            masks::vertical & ~0x0100000000000001;
-        static constexpr bitboard rel_blockers_horizontal =
-            masks::horizontal & ~0x81;
+constexpr auto rook_entries = Rookst::make_entries(rook_magics);
+constexpr auto bishop_entries = Bishopst::make_entries(bishop_magics);
 
-        return (rel_blockers_vertical << index.column()) ^
-            (rel_blockers_horizontal << (index.row() * 8));
-    }
+static_assert(attacks_size == Rookst::table_size() + Bishopst::table_size());
 
-    static inline bitboard slider(square index) {
-        return (masks::horizontal << (index.row() * 8)) ^
-            (masks::vertical << index.column());
-    }
+consteval SliderAttacks make_attacks() {
+    SliderAttacks attacks{};
 
-    static bitboard gen_moves(bitboard blockers, square index) {
-        const bitboard slider = Rookst::slider(index);
-        blockers = blockers.mask(slider);
-
-        const bitboard rook = masks::at(index);
-
-        const bitboard vertical = masks::file(index.column());
-
-        // get the blockers that are over the rook
-        bitboard n_ray = blockers.mask(vertical).exclude(rook - 1);
-        // set the bits between the first blocker and the rook, without the rook
-        n_ray = masks::interval(rook, n_ray.LSB()).mask(vertical) ^ rook;
-
-        // get the blockers that are under the rook
-        bitboard s_ray =
-            // {masks::rank(0)} extra blocker to keep the
-            // interval on the right side
-            blockers.join(masks::rank(0))
-                .mask(vertical)
-                .mask(rook | (rook - 1));
-        // set the bits between the first blocker and the rook
-        s_ray = masks::interval(rook, s_ray.MSB()).mask(vertical) ^ rook;
-
-        const bitboard horizontal = masks::rank(index.row());
-
-        // get the blockers left to the rook
-        bitboard w_ray = blockers.mask(horizontal).exclude(rook - 1);
-        // set the bits between the first blocker and the rook, without the rook
-        w_ray = masks::interval(rook, w_ray.LSB()).mask(horizontal) ^ rook;
-
-        // get the blockers left to the rook
-        bitboard e_ray =
-            // {masks::file(0)} extra blocker to keep the
-            // interval on the right side
-            blockers.join(masks::file(0))
-                .mask(horizontal)
-                .mask(rook | (rook - 1));
-        // set the bits between the first blocker and the rook, without the rook
-        e_ray = masks::interval(rook, e_ray.MSB()).mask(horizontal) ^ rook;
-
-        return n_ray | s_ray | w_ray | e_ray;
-    }
+    Rookst::fill_attacks(attacks, rook_entries);
+    Bishopst::fill_attacks(attacks, bishop_entries);
+
+    return attacks;
+}
+
+// Generated at compile time so the tables live in read-only data,
+// cost nothing at startup and are shared between processes
+constexpr SliderAttacks attacks = make_attacks();
+
+inline bitboard get_moves(const MagicEntry& entry, bitboard blockers) {
+    return attacks.magic[entry.offset + entry.magic_index(blockers)];
+}
+
+template <const auto& entries>
+static bitboard get_moves_at(bitboard blockers, square index) {
+    return get_moves(entries[index], blockers);
+}
+
+#ifdef MAGIC_HAS_PEXT
+/*
+ * Returns `true` if the CPU can execute PEXT (BMI2).
+ */
+static bool pext_supported() {
+    unsigned eax, ebx, ecx, edx;
+
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+
+    return ebx & bit_BMI2;
+}
+
+/*
+ * Returns `true` if PEXT is implemented in hardware.
+ * AMD cores before Zen 3 (family 19h) run it in microcode,
+ * taking hundreds of cycles.
+ */
+static bool pext_fast() {
+    if (!pext_supported()) return false;
+
+    unsigned eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(0, &eax, &ebx, &ecx, &edx)) return false;
+
+    if (ebx != signature_AMD_ebx) return true;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+
+    unsigned family = (eax >> 8) & 0xF;
+    if (family == 0xF) family += (eax >> 20) & 0xFF;
+
+    return family >= 0x19;
+}
+
+__attribute__((target("bmi2"))) inline bitboard get_moves_pext(
+    const MagicEntry& entry, bitboard blockers) {
+    return attacks.pext[entry.offset + _pext_u64(blockers, entry.mask)];
+}
+
+template <const auto& entries>
+__attribute__((target("bmi2"))) static bitboard get_moves_pext_at(
+    bitboard blockers, square index) {
+    return get_moves_pext(entries[index], blockers);
+}
+
+// Lookups of the selected backend, called without branching on it
+struct Dispatch {
+    Backend backend;
+
+    bitboard (*rooks)(bitboard blockers, square index);
+    bitboard (*bishops)(bitboard blockers, square index);
 };
 
-struct Bishopst : public MagicTable<Bishopst, 9> {
-    static inline bitboard relevant_blockers(square index) {
-        return slider(index).exclude(masks::border);
-    }
+constexpr Dispatch magic_dispatch = {Backend::MAGIC,
+    get_moves_at<rook_entries>, get_moves_at<bishop_entries>};
 
-    static inline bitboard slider(square index) {
-        return masks::diagonal_at(index) ^ masks::rev_diagonal_at(index);
-    }
+constexpr Dispatch pext_dispatch = {Backend::PEXT,
+    get_moves_pext_at<rook_entries>, get_moves_pext_at<bishop_entries>};
 
-    static bitboard gen_moves(bitboard blockers, square index) {
-        const bitboard slider = Bishopst::slider(index);
-        blockers = blockers.mask(slider);
-
-        const bitboard bishop = masks::at(index);
-
-        const bitboard diagonal = masks::diagonal_at(index);
-
-        // get the blockers over and to the right of the bishop
-        bitboard ne_ray = blockers.mask(diagonal).exclude(bishop - 1);
-        // set the bits between the bishop and the first blocker,
-        // without the bishop
-        ne_ray = masks::interval(bishop, ne_ray.LSB()).mask(diagonal) ^ bishop;
-
-        // get the blockers under and to the left of the bishop
-        bitboard sw_ray =
-            // {masks::file(7) | masks::rank(0)} extra blocker to keep the
-            // interval on the right side
-            blockers.join(masks::file(7) | masks::rank(0))
-                .mask(diagonal)
-                .mask(bishop | (bishop - 1));
-        // set the bits between the bishop and the first blocker,
-        // without the bishop
-        sw_ray = masks::interval(bishop, sw_ray.MSB()).mask(diagonal) ^ bishop;
-
-        const bitboard rdiagonal = masks::rev_diagonal_at(index);
-
-        // get the blockers over and to the left of the bishop
-        bitboard nw_ray = blockers.mask(rdiagonal).exclude(bishop - 1);
-        // set the bits between the bishop and the first blocker,
-        // without the bishop
-        nw_ray = masks::interval(bishop, nw_ray.LSB()).mask(rdiagonal) ^ bishop;
-
-        // get the blockers under and to the right of the bishop
-        bitboard se_ray =
-            // {masks::file(0) | masks::rank(0)} extra blocker to keep the
-            // interval on the right side
-            blockers.join(masks::file(0) | masks::rank(0))
-                .mask(rdiagonal)
-                .mask(bishop | (bishop - 1));
-        // set the bits between the bishop and the first blocker,
-        // without the bishop
-        se_ray = masks::interval(bishop, se_ray.MSB()).mask(rdiagonal) ^ bishop;
-
-        return ne_ray | sw_ray | nw_ray | se_ray;
+static constinit Dispatch dispatch = magic_dispatch;
+
+// pick PEXT once, where the CPU runs it in hardware
+static struct BackendSelector {
+    BackendSelector() {
+        if (pext_fast()) dispatch = pext_dispatch;
     }
-};
+} backend_selector;
 
-bitboard rooks::get_avail_moves(bitboard blockers, square index) {
-    return Rookst::get_moves(blockers, index);
+Backend get_backend() { return dispatch.backend; }
+
+bool set_backend(Backend selected) {
+    if (selected == Backend::PEXT && !pext_supported()) return false;
+
+    dispatch = selected == Backend::PEXT ? pext_dispatch : magic_dispatch;
+    return true;
 }
 
-bitboard rooks::get_slider(square index) { return Rookst::slider(index); }
+bitboard rooks::get_avail_moves(bitboard blockers, square index) {
+    return dispatch.rooks(blockers, index);
+}
 
 bitboard bishops::get_avail_moves(bitboard blockers, square index) {
-    return Bishopst::gen_moves(blockers, index);
+    return dispatch.bishops(blockers, index);
 }
+#else
+// Magics measured faster than PEXT even on CPUs with fast BMI2,
+// without CHESSY_PEXT they are the only backend and called directly
 
-bitboard bishops::get_slider(square index) { return Bishopst::slider(index); }
+Backend get_backend() { return Backend::MAGIC; }
 
-template <>
-// Generated using maggen binary
-const std::array<uint64_t, 64> MagicTable<Rookst, 12>::precalc_magics = {
-    0x2080028220400012UL,
-    0xD40009000600048UL,
-    0xA280081000A00006UL,
-    0x280049000020800UL,
-    0x800608000400C1UL,
-    0x1080040051048600UL,
-    0x4600040228004183UL,
-    0x200008600C12304UL,
-    0x8000201A4004UL,
-    0x8101001080040UL,
-    0x2000E00064004020UL,
-    0x404002081100UL,
-    0x6002002052008804UL,
-    0x808004084222408UL,
-    0x12084100404080UL,
-    0x242000841240102UL,
-    0x248000104000UL,
-    0x100801040080440CUL,
-    0x24080C2002048A02UL,
-    0x401C20400E080040UL,
-    0x880804880040100UL,
-    0x283D010122000400UL,
-    0x200004002800100UL,
-    0x3002450000403082UL,
-    0x2080201080084000UL,
-    0x4204000AA0014110UL,
-    0x88004090045080UL,
-    0x4418440040524UL,
-    0x1010010022080C0UL,
-    0x20109010042C0020UL,
-    0x2802802028100040UL,
-    0x804040200008033UL,
-    0x82164000A1800015UL,
-    0x410106002800881UL,
-    0x8021060200A1000UL,
-    0x294218D001000501UL,
-    0x4100200402201100UL,
-    0x1801C0200210080UL,
-    0x20084200004000A1UL,
-    0x8060002041800100UL,
-    0x2040400820108001UL,
-    0x48100308088400UL,
-    0x50094800210800C0UL,
-    0x101804800C10284UL,
-    0x1800080200010300UL,
-    0xA500200104A8004UL,
-    0x1020210008201UL,
-    0x81825411820009UL,
-    0xE0284011800100UL,
-    0x4888800100818UL,
-    0xE00048A002100008UL,
-    0x810410000280UL,
-    0x2008800458026100UL,
-    0x204008401041020UL,
-    0x800024A002110440UL,
-    0x842344038200UL,
-    0x100010820900C162UL,
-    0x4102100AC0018021UL,
-    0xA88020104086UL,
-    0xA111820400402UL,
-    0x2021004080003UL,
-    0x20080228840001UL,
-    0x810440B040624804UL,
-    0x80040B0348840022UL,
-};
+bool set_backend(Backend selected) { return selected == Backend::MAGIC; }
 
-template <>
-// Generated using maggen binary
-const std::array<uint64_t, 64> MagicTable<Bishopst, 9>::precalc_magics = {
-    0x4144050014004009UL,
-    0x89A0082208404080UL,
-    0x4080E84100221010UL,
-    0x8C40080008000UL,
-    0x40403001200000UL,
-    0x400100225020A80UL,
-    0x1000802281420008UL,
-    0x4021090008401UL,
-    0x942000420180UL,
-    0x44220490414050UL,
-    0x1044020404000E00UL,
-    0x420005010086A802UL,
-    0x400080842008800UL,
-    0x1A412010088120UL,
-    0x88B0508885002UL,
-    0x42040400240C80UL,
-    0xC20A00063040018UL,
-    0x4004C0080888080UL,
-    0x8400804A00200420UL,
-    0x2820400200810002UL,
-    0x8010040200820000UL,
-    0x100A000040202200UL,
-    0x2002088004108UL,
-    0x2002092104210010UL,
-    0x40A40102020420UL,
-    0x1188020000344040UL,
-    0xC30100078004841UL,
-    0x90800020A0040UL,
-    0xD010010104010UL,
-    0x511406200440041UL,
-    0x2302500680801800UL,
-    0x9000840291840011UL,
-    0x1180410062044UL,
-    0x20010500A040100UL,
-    0x1106000C0214UL,
-    0x80020180280280UL,
-    0x10088200042200UL,
-    0x114040040100920UL,
-    0x480C22E02208012UL,
-    0x42F01802026516UL,
-    0x8000101601445090UL,
-    0x91010011000184UL,
-    0x14806440200102UL,
-    0xD20400240400UL,
-    0x402010104020600UL,
-    0x4820002142014010UL,
-    0x542604644000040UL,
-    0x8400402890200200UL,
-    0x30801005A2080UL,
-    0x86001100892408UL,
-    0x805902C04006040UL,
-    0x2624021410UL,
-    0x224000040903818UL,
-    0x1008303820800UL,
-    0x8042040410800418UL,
-    0xA00020C84200C008UL,
-    0x8002108044004140UL,
-    0x2020010400800C0UL,
-    0x800020A11120200UL,
-    0x202020200C12040UL,
-    0x4000201540030E00UL,
-    0x80140A10030008UL,
-    0x160400200141010UL,
-    0x801010AA02802002UL,
-};
+bitboard rooks::get_avail_moves(bitboard blockers, square index) {
+    return get_moves_at<rook_entries>(blockers, index);
+}
+
+bitboard bishops::get_avail_moves(bitboard blockers, square index) {
+    return get_moves_at<bishop_entries>(blockers, index);
+}
+#endif
+
+#endif
+
+bitboard rooks::get_slider(square index) { return Rookst::slider(index); }
 
-// force initialization
-template struct MagicTable<Rookst, 12>;
-template struct MagicTable<Bishopst, 9>;
+bitboard bishops::get_slider(square index) { return Bishopst::slider(index); }
 
 }  // namespace core::generation::magic
 
@@ -481,7 +598,7 @@ int main() {
     std::println("Starting rook magic number search");
     auto magics = core::generation::magic::Rookst::precalculate_magic();
 
-    std::println("static constexpr uint64_t precalc_rook_magics[64]{{");
+    std::println("constexpr std::array<uint64_t, 64> rook_magics = {{");
     for (auto magic : magics) {
         std::println("0x{:X}UL,", magic);
     }
@@ -490,7 +607,7 @@ int main() {
     std::println("Starting bishop magic number search\n");
     magics = core::generation::magic::Bishopst::precalculate_magic();
 
-    std::println("static constexpr uint64_t precalc_bishop_magics[64]{{");
+    std::println("constexpr std::array<uint64_t, 64> bishop_magics = {{");
     for (auto magic : magics) {
         std::println("0x{:X}UL,", magic);
     }
@@ -3,6 +3,19 @@
 #define CORE_PRIMITIVES_ONLY
 #include <core/types.hpp>
 
+namespace core::generation::magic {
+// Slider lookup implementations, magics by default
+// (PEXT when built with CHESSY_PEXT on a CPU with fast BMI2)
+enum class Backend : uint8_t { MAGIC, PEXT };
+
+Backend get_backend();
+
+// Returns `false` if the backend is not built in or the CPU lacks it.
+// Not synchronised with the lookups,
+// only call it before any search or perft starts
+bool set_backend(Backend backend);
+}  // namespace core::generation::magic
+
 namespace core::generation::magic::rooks {
 bitboard get_avail_moves(bitboard blockers, square index);
 bitboard get_slider(square index);
@@ -1,5 +1,8 @@
 #include "notation.hpp"
 
+#include <core/generation.hpp>
+#include <core/zobrist.hpp>
+
 #include <cctype>
 #include <format>
 
@@ -154,6 +157,10 @@ core::Board core::notation::FEN::parse_string(std::string_view fen) {
         }
     }
 
+    generation::update_state(parsed);
+
+    parsed.hash = zobrist::hash(parsed);
+
     return parsed;
 }
 
@@ -263,6 +270,7 @@ core::Board::Positions core::notation::FEN::parse_placement_data(
 
                 parsed.pieces[piece] |= index.bb();
                 parsed.colors[color] |= index.bb();
+                parsed.mailbox[index] = piece;
 
                 file--;
             }
@@ -315,7 +323,7 @@ core::Board::State::Castling core::notation::FEN::parse_castling_availability(
     }
 
     if (str.find('q') != std::string::npos) {
-        castling.black_right = true;
+        castling.black_left = true;
     }
 
     return castling;
@@ -347,13 +355,13 @@ const core::notation::MoveLAN core::notation::MoveLAN::parse_string(
 
 const core::notation::MoveLAN core::notation::MoveLAN::from_move(
     Move move) noexcept(true) {
-    return MoveLAN{move.from, move.to, move.promotion};
+    return MoveLAN{move.from(), move.to(), move.promotion()};
 }
 
 bool core::notation::MoveLAN::matches_move(Move move) noexcept(true) {
-    if (this->from != move.from) return false;
-    if (this->to != move.to) return false;
-    if (this->promotion != move.promotion) return false;
+    if (this->from != move.from()) return false;
+    if (this->to != move.to()) return false;
+    if (this->promotion != move.promotion()) return false;
 
     return true;
 }
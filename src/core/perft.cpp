@@ -0,0 +1,364 @@
+#include "perft.hpp"
+
+#include <core/generation.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/*
+ * Returns the number of leaf nodes `depth` plies below the board.
+ *
+ * The last ply is only counted, not played.
+ * The board is left as it was.
+ */
+uint64_t core::perft::count_nodes(Board& board, int depth) {
+    if (depth <= 0) return 1;
+
+    if (depth == 1) return generation::count_moves(board);
+
+    generation::MoveList moves;
+    generation::generate_moves(board, moves);
+
+    uint64_t nodes = 0;
+
+    for (const Move& move : moves) {
+        auto state = board.play(move);
+        nodes += count_nodes(board, depth - 1);
+        board.unplay(move, state);
+    }
+
+    return nodes;
+}
+
+/*
+ * Counts the nodes under the board on top of `stack`,
+ * each child is a copy of its parent placed on the next slot.
+ */
+static uint64_t count_nodes_copy_make(core::Board* stack, int depth) {
+    using namespace core;
+
+    if (depth == 1) return generation::count_moves(*stack);
+
+    generation::MoveList moves;
+    generation::generate_moves(*stack, moves);
+
+    Board* child = stack + 1;
+
+    uint64_t nodes = 0;
+
+    for (const Move& move : moves) {
+        *child = *stack;
+        child->apply(move);
+
+        nodes += count_nodes_copy_make(child, depth - 1);
+    }
+
+    return nodes;
+}
+
+/*
+ * Same as `count_nodes`, copying the board on a stack for every ply
+ * instead of playing and unplaying moves on a single board.
+ */
+uint64_t core::perft::count_nodes_copy_make(const Board& board, int depth) {
+    if (depth <= 0) return 1;
+
+    std::vector<Board> stack(depth);
+    stack[0] = board;
+
+    return ::count_nodes_copy_make(stack.data(), depth);
+}
+
+/*
+ * Same as `count_nodes`, looking up and storing
+ * the count of every subtree deeper than one ply in `table`.
+ *
+ * Probes and hits are added to `stats`.
+ */
+uint64_t core::perft::count_nodes(
+    Board& board, int depth, HashTable& table, HashTable::Stats& stats) {
+    // leaves are cheaper to count than to hash
+    if (depth <= 1) return count_nodes(board, depth);
+
+    uint64_t hash = board.hash;
+
+    ++stats.probes;
+
+    if (auto nodes = table.probe(hash, depth)) {
+        ++stats.hits;
+        return *nodes;
+    }
+
+    generation::MoveList moves;
+    generation::generate_moves(board, moves);
+
+    uint64_t nodes = 0;
+
+    for (const Move& move : moves) {
+        auto state = board.play(move);
+        nodes += count_nodes(board, depth - 1, table, stats);
+        board.unplay(move, state);
+    }
+
+    table.store(hash, depth, nodes);
+
+    return nodes;
+}
+
+/*
+ * Returns the leaf nodes under each legal move of the board,
+ * in generation order.
+ *
+ * Subtree counts are cached in `table` if one is given.
+ */
+std::vector<core::perft::Divide> core::perft::divide(
+    Board& board, int depth, HashTable* table) {
+    std::vector<Divide> divided;
+
+    if (depth <= 0) return divided;
+
+    generation::MoveList moves;
+    generation::generate_moves(board, moves);
+
+    HashTable::Stats stats;
+
+    for (const Move& move : moves) {
+        auto state = board.play(move);
+
+        uint64_t nodes = table ? count_nodes(board, depth - 1, *table, stats)
+                               : count_nodes(board, depth - 1);
+
+        divided.push_back({move, nodes});
+
+        board.unplay(move, state);
+    }
+
+    if (table) table->add_stats(stats);
+
+    return divided;
+}
+
+/********************************# Hash Table #********************************/
+
+core::perft::HashTable::HashTable(size_t mib) {
+    size_t count = std::max<size_t>(1, (mib << 20) / sizeof(Bucket));
+
+    // a power of two so the bucket is picked by masking the hash
+    bucket_count = std::bit_floor(count);
+    buckets = std::make_unique<Bucket[]>(bucket_count);
+}
+
+std::optional<uint64_t> core::perft::HashTable::probe(
+    uint64_t hash, int depth) const {
+    for (const Entry& entry : bucket_at(hash).entries) {
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+
+        if ((check ^ data) == hash && (data & 0xFF) == uint64_t(depth)) {
+            return data >> 8;
+        }
+    }
+
+    return std::nullopt;
+}
+
+/*
+ * Stores a count over the same position and depth if present,
+ * otherwise over the shallowest entry of the bucket.
+ */
+void core::perft::HashTable::store(uint64_t hash, int depth, uint64_t nodes) {
+    Entry* replaced = nullptr;
+    uint64_t replaced_depth = UINT64_MAX;
+
+    for (Entry& entry : bucket_at(hash).entries) {
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+
+        if ((check ^ data) == hash && (data & 0xFF) == uint64_t(depth)) {
+            replaced = &entry;
+            break;
+        }
+
+        if ((data & 0xFF) < replaced_depth) {
+            replaced = &entry;
+            replaced_depth = data & 0xFF;
+        }
+    }
+
+    uint64_t data = nodes << 8 | uint8_t(depth);
+
+    replaced->check.store(hash ^ data, std::memory_order_relaxed);
+    replaced->data.store(data, std::memory_order_relaxed);
+}
+
+void core::perft::HashTable::clear() {
+    for (size_t index = 0; index < bucket_count; ++index) {
+        for (Entry& entry : buckets[index].entries) {
+            entry.check.store(0, std::memory_order_relaxed);
+            entry.data.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    probes = 0;
+    hits = 0;
+}
+
+void core::perft::HashTable::add_stats(const Stats& local) {
+    probes.fetch_add(local.probes, std::memory_order_relaxed);
+    hits.fetch_add(local.hits, std::memory_order_relaxed);
+}
+
+core::perft::HashTable::Stats core::perft::HashTable::stats() const {
+    return {probes.load(), hits.load()};
+}
+
+/******************************# Parallel Perft #******************************/
+
+namespace core::perft {
+
+// A subtree counted by a single worker, with its own copy of the board
+struct Task {
+    Board board;
+    int depth;
+    size_t root;
+};
+
+/*
+ * Tasks of a worker, the owner takes from the back
+ * and the other workers steal from the front.
+ */
+class TaskQueue {
+   private:
+    std::mutex mutex;
+    std::deque<Task> tasks;
+
+   public:
+    void push(Task&& task) {
+        std::lock_guard lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+
+    std::optional<Task> pop() {
+        std::lock_guard lock(mutex);
+
+        if (tasks.empty()) return std::nullopt;
+
+        Task task = std::move(tasks.back());
+        tasks.pop_back();
+        return task;
+    }
+
+    std::optional<Task> steal() {
+        std::lock_guard lock(mutex);
+
+        if (tasks.empty()) return std::nullopt;
+
+        Task task = std::move(tasks.front());
+        tasks.pop_front();
+        return task;
+    }
+};
+
+/*
+ * Plays `plies` more plies and collects the positions reached as tasks.
+ */
+static void split_tree(Board& board, int depth, int plies, size_t root,
+    std::vector<Task>& tasks) {
+    if (plies <= 0 || depth <= 1) {
+        tasks.push_back({board, depth, root});
+        return;
+    }
+
+    generation::MoveList moves;
+    generation::generate_moves(board, moves);
+
+    for (const Move& move : moves) {
+        auto state = board.play(move);
+        split_tree(board, depth - 1, plies - 1, root, tasks);
+        board.unplay(move, state);
+    }
+}
+
+}  // namespace core::perft
+
+/*
+ * Same as `divide`, with the subtrees counted by a pool of workers.
+ *
+ * The tree is expanded `split_depth` plies from the root
+ * and the positions reached are dealt to the workers,
+ * a worker that runs out of tasks steals from the others.
+ * Nothing is added to the queues once the workers start,
+ * so a worker stops when every queue is empty.
+ *
+ * Workers share the subtree counts of `options.table` if set.
+ */
+std::vector<core::perft::Divide> core::perft::divide_parallel(
+    const Board& board, int depth, ParallelOptions options) {
+    std::vector<Divide> divided;
+
+    if (depth <= 0) return divided;
+
+    unsigned threads = options.threads;
+
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    Board root = board;
+
+    generation::MoveList moves;
+    generation::generate_moves(root, moves);
+
+    std::vector<Task> tasks;
+
+    for (size_t index = 0; index < moves.size(); ++index) {
+        auto state = root.play(moves[index]);
+        split_tree(root, depth - 1, options.split_depth - 1, index, tasks);
+        root.unplay(moves[index], state);
+    }
+
+    std::vector<TaskQueue> queues(threads);
+
+    for (size_t index = 0; index < tasks.size(); ++index) {
+        queues[index % threads].push(std::move(tasks[index]));
+    }
+
+    std::vector<std::atomic<uint64_t>> nodes(moves.size());
+
+    auto work = [&](unsigned id) {
+        HashTable::Stats stats;
+
+        while (true) {
+            auto task = queues[id].pop();
+
+            for (unsigned offset = 1; !task && offset < threads; ++offset) {
+                task = queues[(id + offset) % threads].steal();
+            }
+
+            if (!task) break;
+
+            uint64_t count = options.table
+                ? count_nodes(task->board, task->depth, *options.table, stats)
+                : count_nodes(task->board, task->depth);
+
+            nodes[task->root].fetch_add(count, std::memory_order_relaxed);
+        }
+
+        if (options.table) options.table->add_stats(stats);
+    };
+
+    {
+        std::vector<std::jthread> workers;
+
+        for (unsigned id = 1; id < threads; ++id) workers.emplace_back(work, id);
+
+        work(0);
+    }
+
+    for (size_t index = 0; index < moves.size(); ++index) {
+        divided.push_back({moves[index], nodes[index].load()});
+    }
+
+    return divided;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <core/types.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace core::perft {
+
+// Nodes found under one of the root moves
+struct Divide {
+    Move move;
+    uint64_t nodes;
+};
+
+/*
+ * Fixed size cache of subtree node counts,
+ * keyed by the position hash and the remaining depth.
+ *
+ * Entries are grouped in buckets the size of a cache line.
+ * Safe to share between threads without locks:
+ * the key is stored xored with the data,
+ * so an entry torn by two concurrent writes never matches.
+ */
+class HashTable {
+   public:
+    struct Stats {
+        uint64_t probes = 0, hits = 0;
+
+        inline double hit_rate() const {
+            return probes ? double(hits) / probes : 0;
+        }
+    };
+
+    explicit HashTable(size_t mib);
+
+    std::optional<uint64_t> probe(uint64_t hash, int depth) const;
+    void store(uint64_t hash, int depth, uint64_t nodes);
+
+    void clear();
+
+    inline size_t size() const { return bucket_count * sizeof(Bucket); }
+
+    // probes and hits are gathered by each caller and added at the end
+    void add_stats(const Stats& local);
+    Stats stats() const;
+
+   private:
+    struct Entry {
+        std::atomic<uint64_t> check;
+        // nodes in the high 56 bits, depth in the low 8
+        std::atomic<uint64_t> data;
+    };
+
+    struct alignas(64) Bucket {
+        Entry entries[4];
+    };
+
+    static_assert(sizeof(Bucket) == 64);
+
+    std::unique_ptr<Bucket[]> buckets;
+    size_t bucket_count;
+
+    std::atomic<uint64_t> probes = 0, hits = 0;
+
+    inline Bucket& bucket_at(uint64_t hash) const {
+        return buckets[hash & (bucket_count - 1)];
+    }
+};
+
+uint64_t count_nodes(Board& board, int depth);
+
+uint64_t count_nodes_copy_make(const Board& board, int depth);
+
+uint64_t count_nodes(Board& board, int depth, HashTable& table,
+    HashTable::Stats& stats);
+
+std::vector<Divide> divide(
+    Board& board, int depth, HashTable* table = nullptr);
+
+// Splitting of the tree for the parallel search
+struct ParallelOptions {
+    // workers, 0 uses every hardware thread
+    unsigned threads = 0;
+
+    // plies played before handing subtrees to the workers
+    int split_depth = 2;
+
+    // subtree counts shared by every worker, none if null
+    HashTable* table = nullptr;
+};
+
+std::vector<Divide> divide_parallel(
+    const Board& board, int depth, ParallelOptions options = {});
+
+}  // namespace core::perft
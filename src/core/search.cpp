@@ -0,0 +1,489 @@
+#include "search.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace core {
+
+using search::score_t;
+
+search::Search::Search(Board& board, History& history, Limits limits,
+    transposition::Table* table)
+    : board(board), history(history), limits(limits), table(table) {}
+
+/*
+ * Mate scores are stored relative to the position instead of the root,
+ * so they stay right when the position is reached at another ply.
+ */
+static score_t score_to_table(score_t score, int ply) {
+    if (score >= search::mate_bound) return score + ply;
+    if (score <= -search::mate_bound) return score - ply;
+
+    return score;
+}
+
+static score_t score_from_table(score_t score, int ply) {
+    if (score >= search::mate_bound) return score - ply;
+    if (score <= -search::mate_bound) return score + ply;
+
+    return score;
+}
+
+bool search::Search::should_stop() const {
+    if (shared_stop && shared_stop->load(std::memory_order_relaxed)) return true;
+
+    // always finish the first iteration to have a move
+    if (iteration_depth <= 1) return false;
+
+    if (limits.nodes && nodes >= limits.nodes) return true;
+
+    if (limits.time.count()) {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        if (elapsed >= limits.time) return true;
+    }
+
+    return false;
+}
+
+// Quiet history scores are halved when one reaches this
+constexpr int quiet_history_limit = 1 << 20;
+
+/*
+ * Sorts `first` to the front, then captures and promotions
+ * by most valuable victim and least valuable attacker,
+ * then the killers of the ply, the captures that lose material
+ * and the other quiet moves by their history.
+ */
+void search::Search::order_moves(
+    generation::MoveList& moves, Move first, int ply) const {
+    const Frame& frame = stack[ply];
+    const auto& history_of_side = quiet_history[board.active_color];
+
+    auto score = [&](Move move) {
+        if (move == first) return 1 << 30;
+
+        if (move.is_capture()) {
+            Piece victim =
+                move.is_en_passant() ? Piece(Piece::PAWNS) : board.piece(move.to());
+
+            int score = victim * 8 - board.piece(move.from());
+
+            if (move.is_promotion()) score += move.promotion() * 8;
+
+            // losing captures go after the killers
+            bool losing = victim < board.piece(move.from()) &&
+                          evaluation::see(board, move) < 0;
+
+            return score + (losing ? 1 << 21 : 1 << 24);
+        }
+
+        if (move.is_promotion()) return (1 << 23) + move.promotion() * 8;
+
+        if (move == frame.killers[0]) return (1 << 22) + 1;
+        if (move == frame.killers[1]) return 1 << 22;
+
+        return history_of_side[move.from()][move.to()];
+    };
+
+    std::array<int, generation::max_moves> scores;
+
+    for (int index = 0; index < moves.size(); ++index) {
+        scores[index] = score(moves[index]);
+    }
+
+    // insertion sort, lists are short and mostly quiet moves
+    for (int index = 1; index < moves.size(); ++index) {
+        Move move = moves[index];
+        int value = scores[index];
+
+        int slot = index;
+
+        for (; slot > 0 && scores[slot - 1] < value; --slot) {
+            moves[slot] = moves[slot - 1];
+            scores[slot] = scores[slot - 1];
+        }
+
+        moves[slot] = move;
+        scores[slot] = value;
+    }
+}
+
+/*
+ * Negamax alpha-beta with a null window for every move after the first.
+ *
+ * `follow_pv` is set while the moves played so far
+ * are the start of the previous principal variation.
+ */
+score_t search::Search::alpha_beta(
+    score_t alpha, score_t beta, int depth, int ply, bool follow_pv) {
+    pv_length[ply] = ply;
+
+    if ((++nodes & 1023) == 0 && should_stop()) stopped = true;
+
+    if (stopped) return 0;
+
+    if (ply > 0 &&
+        (history.is_repetition(board) || history.is_fifty_move_draw(board))) {
+        return 0;
+    }
+
+    // look further into checks, they are forcing
+    bool in_check = board.checkers != 0;
+
+    if (in_check) ++depth;
+
+    if (ply >= max_ply - 1) return evaluation::evaluate(board);
+
+    if (depth <= 0) return quiescence(alpha, beta, ply);
+
+    Move table_move;
+
+    if (table) {
+        ++table_stats.probes;
+
+        if (auto entry = table->probe(board.hash)) {
+            ++table_stats.hits;
+
+            table_move = entry->move;
+
+            score_t score = score_from_table(entry->score, ply);
+
+            // only null windows are cut, the principal variation stays whole
+            bool cut = beta - alpha == 1 && ply > 0 && entry->depth >= depth &&
+                       (entry->bound == transposition::Bound::EXACT ||
+                           (entry->bound == transposition::Bound::LOWER &&
+                               score >= beta) ||
+                           (entry->bound == transposition::Bound::UPPER &&
+                               score <= alpha));
+
+            if (cut) return score;
+        }
+    }
+
+    generation::MoveList& moves = stack[ply].moves;
+    generation::generate_moves(board, moves);
+
+    if (moves.empty()) return in_check ? -mate + ply : 0;
+
+    Move hint = follow_pv && ply < (int)previous_pv.size() ? previous_pv[ply]
+                                                          : table_move;
+
+    order_moves(moves, hint, ply);
+
+    score_t original_alpha = alpha;
+    score_t best = -infinity;
+    Move best_move;
+
+    for (int index = 0; index < moves.size(); ++index) {
+        Move move = moves[index];
+
+        history.play(board, move);
+
+        if (table) table->prefetch(board.hash);
+
+        score_t score;
+
+        if (index == 0) {
+            score = -alpha_beta(
+                -beta, -alpha, depth - 1, ply + 1, follow_pv && move == hint);
+        } else {
+            score = -alpha_beta(-alpha - 1, -alpha, depth - 1, ply + 1, false);
+
+            // the null window failed high, search again with the full window
+            if (score > alpha && score < beta) {
+                score = -alpha_beta(-beta, -alpha, depth - 1, ply + 1, false);
+            }
+        }
+
+        history.unplay(board);
+
+        if (stopped) return 0;
+
+        if (score > best) {
+            best = score;
+            best_move = move;
+        }
+
+        if (score > alpha) {
+            alpha = score;
+
+            pv[ply][ply] = move;
+
+            for (int next = ply + 1; next < pv_length[ply + 1]; ++next) {
+                pv[ply][next] = pv[ply + 1][next];
+            }
+
+            pv_length[ply] = pv_length[ply + 1];
+        }
+
+        if (alpha >= beta) {
+            if (!move.is_capture() && !move.is_promotion()) {
+                reward_quiet(move, depth, ply);
+            }
+
+            break;
+        }
+    }
+
+    if (table) {
+        auto bound = best >= beta             ? transposition::Bound::LOWER
+                     : best > original_alpha ? transposition::Bound::EXACT
+                                             : transposition::Bound::UPPER;
+
+        // a fail low has no best move, any of them was as bad
+        if (bound == transposition::Bound::UPPER) best_move = Move();
+
+        table->store(board.hash, {best_move, int16_t(score_to_table(best, ply)),
+                                     uint8_t(depth), bound});
+    }
+
+    return best;
+}
+
+// Margin over the captured piece a capture must be able to gain
+constexpr score_t delta_margin = 200;
+
+/*
+ * Searches captures and promotions until the position is quiet,
+ * so the leaves are not evaluated in the middle of an exchange.
+ *
+ * The side to move may stand pat on the static evaluation,
+ * and captures that cannot bring it up to alpha are skipped (delta pruning),
+ * as well as those losing the exchange.
+ * In check every evasion is searched instead, there is no standing pat.
+ */
+score_t search::Search::quiescence(score_t alpha, score_t beta, int ply) {
+    pv_length[ply] = ply;
+
+    if ((++nodes & 1023) == 0 && should_stop()) stopped = true;
+
+    if (stopped) return 0;
+
+    if (ply >= max_ply - 1) return evaluation::evaluate(board);
+
+    generation::GenerationContext context(board);
+
+    generation::MoveList& moves = stack[ply].moves;
+    moves.clear();
+
+    score_t stand_pat = -infinity;
+
+    if (context.in_check) {
+        generation::generate_evasions(context, moves);
+
+        if (moves.empty()) return -mate + ply;
+    } else {
+        stand_pat = evaluation::evaluate(board);
+
+        if (stand_pat >= beta) return stand_pat;
+
+        alpha = std::max(alpha, stand_pat);
+
+        generation::generate_captures(context, moves);
+    }
+
+    order_moves(moves, Move(), ply);
+
+    score_t best = stand_pat;
+
+    for (Move move : moves) {
+        if (!context.in_check && !move.is_promotion()) {
+            Piece victim =
+                move.is_en_passant() ? Piece(Piece::PAWNS) : board.piece(move.to());
+
+            if (stand_pat + evaluation::piece_values[victim] + delta_margin <=
+                alpha) {
+                continue;
+            }
+
+            // the exchange loses material, standing pat is better
+            if (victim < board.piece(move.from()) &&
+                evaluation::see(board, move) < 0) {
+                continue;
+            }
+        }
+
+        history.play(board, move);
+
+        score_t score = -quiescence(-beta, -alpha, ply + 1);
+
+        history.unplay(board);
+
+        if (stopped) return 0;
+
+        best = std::max(best, score);
+
+        if (score > alpha) {
+            alpha = score;
+
+            if (alpha >= beta) break;
+        }
+    }
+
+    return best;
+}
+
+/*
+ * Remembers a quiet move that caused a cutoff,
+ * as a killer of the ply and in the history of its side.
+ */
+void search::Search::reward_quiet(Move move, int depth, int ply) {
+    Frame& frame = stack[ply];
+
+    if (frame.killers[0] != move) {
+        frame.killers[1] = frame.killers[0];
+        frame.killers[0] = move;
+    }
+
+    auto& history_of_side = quiet_history[board.active_color];
+    int& score = history_of_side[move.from()][move.to()];
+
+    score += depth * depth;
+
+    // keeps the scores below the killers, older cutoffs weigh less
+    if (score >= quiet_history_limit) {
+        for (auto& scores : history_of_side) {
+            for (int& value : scores) value /= 2;
+        }
+    }
+}
+
+/*
+ * Searches a narrow window around the previous score,
+ * widening the side that fails until the score falls inside.
+ */
+score_t search::Search::aspiration(int depth, score_t previous) {
+    score_t delta = 25;
+
+    score_t alpha = -infinity, beta = infinity;
+
+    if (depth >= 4) {
+        alpha = std::max(previous - delta, -infinity);
+        beta = std::min(previous + delta, infinity);
+    }
+
+    while (true) {
+        score_t score = alpha_beta(alpha, beta, depth, 0, true);
+
+        if (stopped) return 0;
+
+        if (score <= alpha) {
+            alpha = std::max(score - delta, -infinity);
+        } else if (score >= beta) {
+            beta = std::min(score + delta, infinity);
+        } else {
+            return score;
+        }
+
+        delta *= 2;
+    }
+}
+
+search::Iteration search::Search::run(const Reporter& report) {
+    start = std::chrono::steady_clock::now();
+    nodes = 0;
+    stopped = false;
+    previous_pv.clear();
+    table_stats = {};
+
+    for (Frame& frame : stack) frame.killers[0] = frame.killers[1] = Move();
+    std::memset(quiet_history, 0, sizeof(quiet_history));
+
+    // the threads of a parallel search age the table once for all of them
+    if (table && !shared_stop) table->new_search();
+
+    Iteration best;
+
+    // half the helpers start a ply deeper, so the threads spread over
+    // two depths instead of all searching the same tree
+    int first_depth = 1 + thread_index % 2;
+
+    for (int depth = first_depth; depth <= limits.depth; ++depth) {
+        iteration_depth = depth;
+
+        score_t score = aspiration(depth, best.score);
+
+        if (stopped) break;
+
+        best.depth = depth;
+        best.score = score;
+        best.nodes = nodes;
+        best.elapsed = std::chrono::steady_clock::now() - start;
+        best.pv.assign(pv[0], pv[0] + pv_length[0]);
+        best.hashfull = table ? table->hashfull() : 0;
+
+        previous_pv = best.pv;
+
+        if (report) report(best);
+
+        // no legal moves, deeper searches will not change anything
+        if (best.pv.empty()) break;
+
+        if (should_stop()) break;
+    }
+
+    if (table) table->add_stats(table_stats);
+
+    return best;
+}
+
+/*********************************# Lazy SMP #*********************************/
+
+search::LazySmp::Worker::Worker(const Board& board, const History& history,
+    Limits limits, transposition::Table* table)
+    : board(board),
+      history(history),
+      search(this->board, this->history, limits, table) {}
+
+search::LazySmp::LazySmp(const Board& board, const History& history,
+    Limits limits, transposition::Table& table, unsigned threads)
+    : table(table) {
+    threads = std::max(1u, threads);
+
+    for (unsigned index = 0; index < threads; ++index) {
+        // helpers search until stopped, only the main thread has limits
+        auto worker = std::make_unique<Worker>(
+            board, history, index == 0 ? limits : Limits{}, &table);
+
+        worker->search.shared_stop = &stop;
+        worker->search.thread_index = index;
+
+        workers.push_back(std::move(worker));
+    }
+}
+
+search::Iteration search::LazySmp::run(const Reporter& report) {
+    stop = false;
+    table.new_search();
+
+    auto start = std::chrono::steady_clock::now();
+
+    Iteration result;
+
+    {
+        std::vector<std::jthread> helpers;
+
+        for (size_t index = 1; index < workers.size(); ++index) {
+            helpers.emplace_back(
+                [&worker = *workers[index]] { worker.search.run(); });
+        }
+
+        result = workers[0]->search.run(report);
+
+        stop = true;
+    }
+
+    // the main thread's count stops at its last complete iteration,
+    // the totals of every thread include the unfinished one
+    result.nodes = 0;
+
+    for (auto& worker : workers) result.nodes += worker->search.nodes;
+
+    result.elapsed = std::chrono::steady_clock::now() - start;
+
+    return result;
+}
+
+}  // namespace core
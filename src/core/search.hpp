@@ -0,0 +1,168 @@
+#pragma once
+
+#include <core/evaluation.hpp>
+#include <core/generation.hpp>
+#include <core/history.hpp>
+#include <core/transposition.hpp>
+#include <core/types.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace core::search {
+
+using evaluation::score_t;
+
+constexpr int max_ply = 128;
+
+constexpr score_t infinity = 32000;
+constexpr score_t mate = 31000;
+
+// scores past this bound are mates, the distance is `mate - |score|` plies
+constexpr score_t mate_bound = mate - max_ply;
+
+// When to stop searching, 0 means no limit
+struct Limits {
+    int depth = max_ply - 1;
+    uint64_t nodes = 0;
+    std::chrono::milliseconds time{0};
+};
+
+// A completed iteration of the iterative deepening
+struct Iteration {
+    int depth = 0;
+    score_t score = 0;
+    uint64_t nodes = 0;
+    std::chrono::duration<double> elapsed{0};
+    std::vector<Move> pv;
+
+    // permill of the transposition table in use, 0 without one
+    int hashfull = 0;
+
+    inline double nps() const {
+        return elapsed.count() > 0 ? nodes / elapsed.count() : 0;
+    }
+};
+
+using Reporter = std::function<void(const Iteration&)>;
+
+/*
+ * Iterative deepening principal variation search.
+ *
+ * Plays on the given board and history and leaves both as they were.
+ * The history is used to score repetitions as draws.
+ *
+ * Results are cached in `table` if one is given,
+ * it may be kept between searches.
+ */
+class Search {
+   public:
+    Search(Board& board, History& history, Limits limits = {},
+        transposition::Table* table = nullptr);
+
+    // Returns the last completed iteration, calls `report` after each one
+    Iteration run(const Reporter& report = {});
+
+   private:
+    friend class LazySmp;
+
+    Board& board;
+    History& history;
+    Limits limits;
+
+    transposition::Table* table;
+    transposition::Table::Stats table_stats;
+
+    uint64_t nodes = 0;
+    bool stopped = false;
+
+    // Set when running as one of the threads of a `LazySmp`
+
+    // raised by the main thread once it is done
+    const std::atomic<bool>* shared_stop = nullptr;
+
+    // 0 for the main thread
+    int thread_index = 0;
+
+    // iteration being searched, limits are only checked after the first
+    int iteration_depth = 0;
+
+    std::chrono::steady_clock::time_point start;
+
+    // principal variation of the previous iteration, tried first
+    std::vector<Move> previous_pv;
+
+    // triangular table, the line found from each ply
+    Move pv[max_ply][max_ply];
+    int pv_length[max_ply];
+
+    // Data of each ply, preallocated with the search
+    struct Frame {
+        generation::MoveList moves;
+
+        // quiet moves that caused a cutoff at this ply, newest first
+        Move killers[2];
+    };
+
+    std::array<Frame, max_ply> stack;
+
+    // cutoffs caused by each quiet move, by color, origin and destination
+    int quiet_history[2][64][64];
+
+    bool should_stop() const;
+
+    void reward_quiet(Move move, int depth, int ply);
+
+    score_t alpha_beta(
+        score_t alpha, score_t beta, int depth, int ply, bool follow_pv);
+
+    score_t quiescence(score_t alpha, score_t beta, int ply);
+
+    score_t aspiration(int depth, score_t previous);
+
+    void order_moves(generation::MoveList& moves, Move first, int ply) const;
+};
+
+/*
+ * Lazy SMP, every thread searches the root on its own copy of the board
+ * with its own heuristics and search stack.
+ * Only the transposition table is shared, the helpers fill it
+ * with results the main thread finds when it gets to the same positions.
+ *
+ * The main thread reports its iterations and honours the limits,
+ * the helpers run until it stops them.
+ */
+class LazySmp {
+   public:
+    LazySmp(const Board& board, const History& history, Limits limits,
+        transposition::Table& table, unsigned threads);
+
+    // Returns the last iteration of the main thread,
+    // with the nodes searched by every thread and the whole time taken
+    Iteration run(const Reporter& report = {});
+
+    inline unsigned threads() const { return workers.size(); }
+
+   private:
+    struct Worker {
+        Board board;
+        History history;
+        Search search;
+
+        Worker(const Board& board, const History& history, Limits limits,
+            transposition::Table* table);
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    transposition::Table& table;
+
+    std::atomic<bool> stop = false;
+};
+
+}  // namespace core::search
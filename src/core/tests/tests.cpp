@@ -1,12 +1,20 @@
 #include <core/generation.hpp>
+#include <core/history.hpp>
+#include <core/magic.hpp>
 #include <core/notation.hpp>
+#include <core/perft.hpp>
+#include <core/search.hpp>
+#include <core/transposition.hpp>
 #include <core/types.hpp>
+#include <core/zobrist.hpp>
 
 #include <gtest/gtest.h>
 #define TOML_EXCEPTIONS 0
 #include <toml++/toml.hpp>
 
 #include <algorithm>
+#include <bit>
+#include <chrono>
 #include <filesystem>
 #include <format>
 #include <print>
@@ -41,7 +49,7 @@ TEST_P(MoveGenerationTest, MatchesExpectedMoveCounts) {
 
     for (Piece piece : Piece::All) {
         int produced_count = std::ranges::count_if(
-            moves, [&](Move move) { return move.moved == piece; });
+            moves, [&](Move move) { return board.piece(move.from()) == piece; });
 
         std::string piece_name = notation::piece_toname(piece);
 
@@ -55,6 +63,54 @@ TEST_P(MoveGenerationTest, MatchesExpectedMoveCounts) {
 INSTANTIATE_TEST_SUITE_P(AllPositions, MoveGenerationTest,
     ::testing::ValuesIn(MoveGenerationTestCases));
 
+struct PerftTestCase {
+    std::string name;
+    std::string fen;
+    // expected nodes at each depth, starting from 1
+    std::vector<uint64_t> nodes;
+    int fast_depth;
+};
+
+std::vector<PerftTestCase> PerftTestCases;
+
+// set by --perft-deep, runs every depth of the perft cases
+bool perft_deep = false;
+
+class PerftSuiteTest : public ::testing::TestWithParam<PerftTestCase> {};
+
+TEST_P(PerftSuiteTest, MatchesExpectedNodeCounts) {
+    const auto& test_case = GetParam();
+
+    Board board = notation::FEN::parse_string(test_case.fen);
+
+    int max_depth = perft_deep
+        ? test_case.nodes.size()
+        : std::min<int>(test_case.fast_depth, test_case.nodes.size());
+
+    uint64_t total = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int depth = 1; depth <= max_depth; ++depth) {
+        uint64_t nodes = perft::count_nodes(board, depth);
+
+        EXPECT_EQ(nodes, test_case.nodes[depth - 1])
+            << std::format("FEN: {}\nDepth: {}", test_case.fen, depth);
+
+        total += nodes;
+    }
+
+    auto elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start);
+
+    std::println("INFO:: perft {} depth {}: {} nodes, {:.0f} nodes/s",
+        test_case.name, max_depth, total, total / elapsed.count());
+}
+
+INSTANTIATE_TEST_SUITE_P(AllPositions, PerftSuiteTest,
+    ::testing::ValuesIn(PerftTestCases),
+    [](const auto& info) { return info.param.name; });
+
 constexpr int kDepth = 3;
 
 void test_reversible_move_sequence(Board& board, int depth) {
@@ -62,7 +118,8 @@ void test_reversible_move_sequence(Board& board, int depth) {
 
     const Board original = board;
 
-    auto moves = generation::generate_moves(board);
+    generation::MoveList moves;
+    generation::generate_moves(board, moves);
 
     for (const Move& m : moves) {
         auto s = board.play(m);
@@ -93,6 +150,789 @@ TEST(FENMoveUnmoveTest, PlaysAndUnplaysWithoutCorruption) {
     EXPECT_NO_FATAL_FAILURE({ test_reversible_move_sequence(board, kDepth); });
 }
 
+TEST(FENMoveUnmoveTest, RestoresCapturesPromotionsAndCastling) {
+    for (auto fen : {
+             "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - "
+             "0 1",
+             "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+         }) {
+        Board board = notation::FEN::parse_string(fen);
+
+        EXPECT_NO_FATAL_FAILURE({ test_reversible_move_sequence(board, 2); });
+    }
+}
+
+void test_mailbox_in_sync(Board& board, int depth) {
+    for (square index = 0; index < 64; ++index) {
+        Piece expected = Piece::NONE;
+
+        for (Piece piece : Piece::All) {
+            if (board.pieces[piece][index]) expected = piece;
+        }
+
+        ASSERT_EQ(board.piece(index), expected)
+            << std::format("square {} at depth {}", (square_t)index, depth);
+    }
+
+    if (depth == 0) return;
+
+    for (const Move& m : generation::generate_moves(board)) {
+        auto s = board.play(m);
+        test_mailbox_in_sync(board, depth - 1);
+        board.unplay(m, s);
+    }
+}
+
+TEST(MailboxTest, MatchesBitboardsAfterPlay) {
+    for (auto fen : {
+             "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - "
+             "0 1",
+             "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+         }) {
+        Board board = notation::FEN::parse_string(fen);
+
+        EXPECT_NO_FATAL_FAILURE({ test_mailbox_in_sync(board, 2); });
+    }
+}
+
+void test_state_in_sync(Board& board, int depth) {
+    ASSERT_EQ(board.checkers, generation::get_bitboard_checkers(board));
+    ASSERT_EQ(
+        board.king_danger, generation::get_bitboard_squares_attacked(board));
+
+    ASSERT_EQ(board.pinned,
+        generation::get_bitboard_pieces_pinned(board, board.active_color));
+
+    if (depth == 0) return;
+
+    for (const Move& m : generation::generate_moves(board)) {
+        auto s = board.play(m);
+        test_state_in_sync(board, depth - 1);
+        board.unplay(m, s);
+    }
+}
+
+TEST(StateTest, ChecksAndPinsFollowPlayAndUnplay) {
+    for (auto fen : {
+             "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - "
+             "0 1",
+             "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+             "4k3/8/8/3r4/8/8/3N4/3K2R1 w - - 0 1",
+         }) {
+        Board board = notation::FEN::parse_string(fen);
+
+        EXPECT_NO_FATAL_FAILURE({ test_state_in_sync(board, 3); });
+    }
+}
+
+TEST(MoveTest, PacksFieldsIntoSixteenBits) {
+    static_assert(sizeof(Move) == 2);
+
+    for (square from = 0; from < 64; ++from) {
+        for (square to = 0; to < 64; ++to) {
+            Move quiet(from, to);
+
+            EXPECT_EQ(quiet.from(), from);
+            EXPECT_EQ(quiet.to(), to);
+            EXPECT_FALSE(quiet.is_capture());
+            EXPECT_TRUE(quiet.promotion().isNone());
+        }
+    }
+
+    for (Piece piece :
+        {Piece::KNIGHTS, Piece::BISHOPS, Piece::ROOKS, Piece::QUEENS}) {
+        Move promotion = Move::promote(52, 60, piece);
+        Move capture = Move::promote(52, 61, piece, true);
+
+        EXPECT_EQ(promotion.promotion(), piece);
+        EXPECT_EQ(capture.promotion(), piece);
+
+        EXPECT_FALSE(promotion.is_capture());
+        EXPECT_TRUE(capture.is_capture());
+    }
+
+    EXPECT_TRUE(Move(35, 44, Move::EN_PASSANT).is_capture());
+    EXPECT_TRUE(Move(35, 44, Move::EN_PASSANT).is_en_passant());
+    EXPECT_TRUE(Move(3, 1, Move::CASTLE).is_castle());
+    EXPECT_FALSE(Move(3, 1, Move::CASTLE).is_capture());
+    EXPECT_TRUE(Move(11, 27, Move::DOUBLE_PUSH).is_double_push());
+}
+
+TEST(MoveListTest, MatchesVectorGenerationAndReuses) {
+    Board board = notation::FEN::parse_string(
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+
+    auto expected = generation::generate_moves(board);
+
+    generation::MoveList moves;
+
+    // generating twice into the same list must not accumulate moves
+    for (int i = 0; i < 2; ++i) {
+        generation::generate_moves(board, moves);
+
+        ASSERT_EQ(moves.size(), expected.size());
+
+        for (int index = 0; index < moves.size(); ++index) {
+            EXPECT_EQ(moves[index], expected[index]);
+        }
+    }
+
+    moves.sort([](Move a, Move b) { return a.to() < b.to(); });
+
+    EXPECT_TRUE(std::ranges::is_sorted(
+        moves, [](Move a, Move b) { return a.to() < b.to(); }));
+}
+
+const char* staged_positions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "4k3/8/8/3r4/8/8/3N4/3K2R1 w - - 0 1",
+    "4k3/8/8/8/8/2B5/8/R3K2R w KQ - 0 1",
+    "4k3/8/8/8/4N3/8/2B5/K3R3 w - - 0 1",
+    "8/4k3/8/3pP3/8/8/8/4K3 w - d6 0 2",
+    "5k2/8/8/8/8/8/8/4K2R w K - 0 1",
+};
+
+TEST(StagedGenerationTest, CapturesAndQuietsPartitionMoves) {
+    for (auto fen : staged_positions) {
+        Board board = notation::FEN::parse_string(fen);
+
+        generation::MoveList all;
+        generation::generate_moves(board, all);
+
+        generation::GenerationContext context(board);
+
+        if (context.in_check) continue;
+
+        generation::MoveList captures, quiets;
+        generation::generate_captures(context, captures);
+        generation::generate_quiets(context, quiets);
+
+        EXPECT_EQ(captures.size() + quiets.size(), all.size())
+            << std::format("FEN: {}", fen);
+
+        for (const Move& move : captures) {
+            EXPECT_TRUE(move.is_capture() || move.is_promotion())
+                << std::format("FEN: {}", fen);
+
+            EXPECT_TRUE(std::ranges::any_of(
+                all, [&](const Move& m) { return m == move; }));
+        }
+
+        for (const Move& move : quiets) {
+            EXPECT_TRUE(!move.is_capture() && !move.is_promotion())
+                << std::format("FEN: {}", fen);
+
+            EXPECT_TRUE(std::ranges::any_of(
+                all, [&](const Move& m) { return m == move; }));
+        }
+    }
+}
+
+TEST(CountGenerationTest, MatchesGeneratedMovesAfterEachMove) {
+    for (auto fen : staged_positions) {
+        Board board = notation::FEN::parse_string(fen);
+
+        auto moves = generation::generate_moves(board);
+
+        EXPECT_EQ(generation::count_moves(board), moves.size())
+            << std::format("FEN: {}", fen);
+
+        // one ply deeper to also count evasions and the other color
+        for (const Move& move : moves) {
+            auto state = board.play(move);
+            auto lan = notation::MoveLAN::from_move(move);
+
+            EXPECT_EQ(generation::count_moves(board),
+                generation::generate_moves(board).size())
+                << std::format("FEN: {} Move: {}", fen, lan.to_string());
+
+            board.unplay(move, state);
+        }
+    }
+}
+
+TEST(PerftTest, DivideAddsUpToNodeCount) {
+    // Kiwipete, both sides keep every castling right
+    Board board = notation::FEN::parse_string(
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+
+    const Board original = board;
+
+    EXPECT_EQ(perft::count_nodes(board, 3), 97862);
+
+    auto divided = perft::divide(board, 2);
+
+    uint64_t nodes = 0;
+    for (auto [move, count] : divided) nodes += count;
+
+    EXPECT_EQ(divided.size(), 48);
+    EXPECT_EQ(nodes, 2039);
+    EXPECT_EQ(board, original);
+}
+
+TEST(PerftTest, CopyMakeMatchesMakeUnmake) {
+    for (auto fen : staged_positions) {
+        Board board = notation::FEN::parse_string(fen);
+        const Board original = board;
+
+        EXPECT_EQ(perft::count_nodes_copy_make(board, 3),
+            perft::count_nodes(board, 3))
+            << std::format("FEN: {}", fen);
+
+        EXPECT_EQ(board, original);
+    }
+}
+
+TEST(PerftTest, ParallelDivideMatchesSequential) {
+    Board board = notation::FEN::parse_string(
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+
+    auto expected = perft::divide(board, 3);
+
+    // more threads than tasks and splits deeper than the tree included
+    for (auto options : std::initializer_list<perft::ParallelOptions>{
+             {1, 1}, {3, 2}, {4, 5}, {64, 1}}) {
+        auto divided = perft::divide_parallel(board, 3, options);
+
+        ASSERT_EQ(divided.size(), expected.size());
+
+        for (size_t index = 0; index < divided.size(); ++index) {
+            EXPECT_EQ(divided[index].move, expected[index].move);
+            EXPECT_EQ(divided[index].nodes, expected[index].nodes)
+                << std::format("threads: {} split: {}", options.threads,
+                       options.split_depth);
+        }
+    }
+}
+
+TEST(PerftTest, HashedCountsMatchUnhashed) {
+    Board board = notation::FEN::parse_string(
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+
+    // small enough for buckets to be overwritten
+    perft::HashTable table(1);
+
+    auto expected = perft::divide(board, 4);
+    auto hashed = perft::divide(board, 4, &table);
+
+    ASSERT_EQ(hashed.size(), expected.size());
+
+    for (size_t index = 0; index < hashed.size(); ++index) {
+        EXPECT_EQ(hashed[index].nodes, expected[index].nodes);
+    }
+
+    EXPECT_GT(table.stats().hits, 0);
+
+    // the warm table is shared with the workers
+    auto parallel = perft::divide_parallel(board, 4, {4, 2, &table});
+
+    for (size_t index = 0; index < parallel.size(); ++index) {
+        EXPECT_EQ(parallel[index].nodes, expected[index].nodes);
+    }
+}
+
+TEST(ZobristTest, TranspositionsHashTheSame) {
+    Board board = notation::FEN::parse_string(
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+
+    auto play = [&](std::string_view lan) {
+        auto selected = notation::MoveLAN::parse_string(lan);
+
+        for (const Move& move : generation::generate_moves(board)) {
+            if (selected.matches_move(move)) {
+                board.play(move);
+                return;
+            }
+        }
+
+        FAIL() << std::format("Move {} not found", lan);
+    };
+
+    Board start = board;
+
+    for (auto lan : {"g1f3", "g8f6", "f3g1", "f6g8"}) play(lan);
+
+    // same pieces and rights, only the move counters changed
+    EXPECT_EQ(zobrist::hash(board), zobrist::hash(start));
+
+    play("e2e4");
+
+    uint64_t hash = zobrist::hash(board);
+
+    // no black pawn can take on e3, the target is left out
+    Board changed = board;
+    changed.en_passant_target_square = square::out_of_bounds;
+    EXPECT_EQ(zobrist::hash(changed), hash);
+
+    // every other part of the state besides the counters changes the hash
+    changed = board;
+    changed.castling_availability.white_left = false;
+    EXPECT_NE(zobrist::hash(changed), hash);
+
+    changed = board;
+    changed.active_color = !changed.active_color;
+    EXPECT_NE(zobrist::hash(changed), hash);
+
+    for (auto lan : {"a7a6", "e4e5", "d7d5"}) play(lan);
+
+    // e5 can take on d6, now the target counts
+    changed = board;
+    changed.en_passant_target_square = square::out_of_bounds;
+    EXPECT_NE(zobrist::hash(changed), zobrist::hash(board));
+}
+
+void test_incremental_hash(Board& board, int depth) {
+    ASSERT_EQ(board.hash, zobrist::hash(board));
+
+    if (depth == 0) return;
+
+    for (const Move& move : generation::generate_moves(board)) {
+        uint64_t before = board.hash;
+
+        auto state = board.play(move);
+        test_incremental_hash(board, depth - 1);
+        board.unplay(move, state);
+
+        ASSERT_EQ(board.hash, before);
+    }
+}
+
+TEST(ZobristTest, IncrementalMatchesRecomputed) {
+    for (auto fen : staged_positions) {
+        Board board = notation::FEN::parse_string(fen);
+
+        // captures, promotions, castling and en passant all show up by then
+        EXPECT_NO_FATAL_FAILURE(test_incremental_hash(board, 3))
+            << std::format("FEN: {}", fen);
+    }
+}
+
+TEST(HistoryTest, DetectsRepetitionsAndFiftyMoves) {
+    Board board = notation::FEN::parse_string(
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+
+    const Board start = board;
+
+    History history;
+
+    auto play = [&](std::string_view lan) {
+        auto selected = notation::MoveLAN::parse_string(lan);
+
+        for (const Move& move : generation::generate_moves(board)) {
+            if (selected.matches_move(move)) {
+                history.play(board, move);
+                return;
+            }
+        }
+
+        FAIL() << std::format("Move {} not found", lan);
+    };
+
+    auto shuffle = {"g1f3", "g8f6", "f3g1", "f6g8"};
+
+    for (auto lan : shuffle) play(lan);
+
+    EXPECT_EQ(history.repetitions(board), 1);
+    EXPECT_TRUE(history.is_repetition(board));
+    EXPECT_FALSE(history.is_threefold_repetition(board));
+
+    for (auto lan : shuffle) play(lan);
+
+    EXPECT_TRUE(history.is_threefold_repetition(board));
+
+    // no white pawn can take on e6,
+    // so the position right after e7e5 repeats without its target
+    play("e2e4");
+    play("e7e5");
+    for (auto lan : shuffle) play(lan);
+
+    EXPECT_EQ(history.repetitions(board), 1);
+
+    // only the plies since the pawn move are scanned
+    for (auto lan : shuffle) play(lan);
+
+    EXPECT_EQ(history.repetitions(board), 2);
+    EXPECT_TRUE(history.is_threefold_repetition(board));
+
+    while (!history.empty()) history.unplay(board);
+
+    EXPECT_EQ(board, start);
+
+    board.halfmove_clock = 100;
+    EXPECT_TRUE(history.is_fifty_move_draw(board));
+}
+
+TEST(HistoryTest, GrowsPastReservedPlies) {
+    Board board = notation::FEN::parse_string(
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+
+    const Board start = board;
+
+    History history;
+
+    // knights going back and forth, the game never ends by itself
+    while (history.size() <= History::reserved_plies) {
+        auto moves = generation::generate_moves(board);
+
+        auto knight = std::ranges::find_if(moves,
+            [&](const Move& m) { return board.piece(m.from()).isKnight(); });
+
+        ASSERT_NE(knight, moves.end());
+        history.play(board, *knight);
+    }
+
+    while (!history.empty()) history.unplay(board);
+
+    EXPECT_EQ(board, start);
+}
+
+TEST(EvaluationTest, IsSymmetricBetweenColors) {
+    // the same position with the colors swapped and the board flipped
+    Board white = notation::FEN::parse_string(
+        "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3");
+    Board black = notation::FEN::parse_string(
+        "rnbqkb1r/pppp1ppp/5n2/4p3/4P3/2N5/PPPP1PPP/R1BQKBNR b KQkq - 2 3");
+
+    EXPECT_EQ(evaluation::evaluate(white), evaluation::evaluate(black));
+}
+
+TEST(GenerationTest, AttackersToRevealsXRays) {
+    Board board = notation::FEN::parse_string(
+        "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1");
+
+    // columns start at the h file
+    auto at = [](std::string_view name) {
+        return square::at(name[1] - '1', 'h' - name[0]);
+    };
+
+    bitboard occupancy = board.all();
+    bitboard attackers = generation::attackers_to(board, at("e5"), occupancy);
+
+    // both knights, the bishop and the rook
+    EXPECT_EQ(std::popcount((bitboard_t)attackers), 4);
+    EXPECT_FALSE(attackers & at("e1").bb());
+
+    // the queens join once the pieces in front of them are gone
+    occupancy &= ~at("e2").bb();
+    attackers = generation::attackers_to(board, at("e5"), occupancy);
+
+    EXPECT_TRUE(attackers & at("e1").bb());
+    EXPECT_FALSE(attackers & at("h8").bb());
+
+    occupancy &= ~at("f6").bb();
+    attackers = generation::attackers_to(board, at("e5"), occupancy);
+
+    EXPECT_TRUE(attackers & at("h8").bb());
+}
+
+TEST(EvaluationTest, StaticExchange) {
+    auto see = [](std::string_view fen, std::string_view lan) {
+        Board board = notation::FEN::parse_string(fen);
+        auto selected = notation::MoveLAN::parse_string(lan);
+
+        for (const Move& move : generation::generate_moves(board)) {
+            if (selected.matches_move(move)) {
+                return evaluation::see(board, move);
+            }
+        }
+
+        ADD_FAILURE() << std::format("Move {} not found", lan);
+        return 0;
+    };
+
+    auto& values = evaluation::piece_values;
+
+    // an undefended pawn
+    EXPECT_EQ(see("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", "e1e5"),
+        values[Piece::PAWNS]);
+
+    // the knight is lost for a pawn, the x-rays behind do not save it
+    EXPECT_EQ(
+        see("1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", "d3e5"),
+        values[Piece::PAWNS] - values[Piece::KNIGHTS]);
+
+    // an even trade of knights
+    EXPECT_EQ(see("4k3/8/3n4/8/4N3/8/8/4K3 w - - 0 1", "e4d6"),
+        values[Piece::KNIGHTS]);
+    EXPECT_EQ(see("4k3/2p5/3n4/8/4N3/8/8/4K3 w - - 0 1", "e4d6"), 0);
+
+    // the king cannot take back a defended piece
+    EXPECT_EQ(see("8/8/8/8/8/1k6/1p5R/1R2K3 w - - 0 1", "b1b2"),
+        values[Piece::PAWNS]);
+
+    // quiet moves to attacked squares lose the piece
+    EXPECT_EQ(see("4k3/8/3p4/8/4R3/8/8/4K3 w - - 0 1", "e4e5"),
+        -values[Piece::ROOKS]);
+
+    // en passant, the captured pawn is not on the destination
+    EXPECT_EQ(see("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", "e5d6"),
+        values[Piece::PAWNS]);
+}
+
+TEST(SearchTest, FindsMateAndRestoresBoard) {
+    Board board =
+        notation::FEN::parse_string("6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1");
+
+    const Board original = board;
+
+    History history;
+
+    std::vector<int> depths;
+
+    search::Search search(board, history, {.depth = 4});
+    auto result = search.run([&](const search::Iteration& iteration) {
+        depths.push_back(iteration.depth);
+    });
+
+    ASSERT_FALSE(result.pv.empty());
+
+    auto lan = notation::MoveLAN::from_move(result.pv[0]);
+
+    EXPECT_EQ(lan.to_string(), "a1a8");
+    EXPECT_EQ(result.score, search::mate - 1);
+    EXPECT_EQ(depths, std::vector<int>({1, 2, 3, 4}));
+
+    EXPECT_EQ(board, original);
+    EXPECT_TRUE(history.empty());
+}
+
+TEST(SearchTest, QuiescenceSeesRecaptures) {
+    // the only capture loses the queen to fxe5, a depth 1 search alone takes it
+    Board board =
+        notation::FEN::parse_string("6k1/8/5p2/4p3/3Q4/8/8/6K1 w - - 0 1");
+
+    History history;
+
+    search::Search search(board, history, {.depth = 1});
+    auto result = search.run();
+
+    ASSERT_FALSE(result.pv.empty());
+
+    auto lan = notation::MoveLAN::from_move(result.pv[0]);
+
+    EXPECT_NE(lan.to_string(), "d4e5");
+    EXPECT_LT(result.score, evaluation::piece_values[Piece::QUEENS]);
+}
+
+TEST(SearchTest, StopsAtNodeLimitAfterFirstIteration) {
+    Board board = notation::FEN::parse_string(
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+
+    History history;
+
+    search::Search search(board, history, {.nodes = 5000});
+    auto result = search.run();
+
+    EXPECT_GE(result.depth, 1);
+    EXPECT_FALSE(result.pv.empty());
+
+    // limits are checked every 1024 nodes
+    EXPECT_LT(result.nodes, 5000 + 1024);
+}
+
+TEST(SearchTest, TableKeepsResultAndSavesNodes) {
+    Board board = notation::FEN::parse_string(
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10");
+
+    History history;
+
+    search::Search plain(board, history, {.depth = 4});
+    auto expected = plain.run();
+
+    transposition::Table table(1);
+
+    search::Search cached(board, history, {.depth = 4}, &table);
+    auto result = cached.run();
+
+    EXPECT_LT(result.nodes, expected.nodes);
+    EXPECT_GT(result.hashfull, 0);
+    EXPECT_GT(table.stats().hits, 0);
+
+    // the same search again starts from the first one's results
+    auto repeated = cached.run();
+
+    EXPECT_LT(repeated.nodes, result.nodes);
+    EXPECT_EQ(repeated.pv.front(), result.pv.front());
+}
+
+TEST(SearchTest, LazySmpFindsMateAndLeavesBoard) {
+    Board board =
+        notation::FEN::parse_string("6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1");
+
+    const Board original = board;
+
+    History history;
+    transposition::Table table(1);
+
+    search::LazySmp search(board, history, {.depth = 5}, table, 3);
+
+    search::Iteration reported;
+    auto result = search.run([&](const auto& it) { reported = it; });
+
+    ASSERT_FALSE(result.pv.empty());
+
+    // every thread is counted, the main one included
+    EXPECT_GT(result.nodes, reported.nodes);
+
+    auto lan = notation::MoveLAN::from_move(result.pv[0]);
+
+    EXPECT_EQ(search.threads(), 3);
+    EXPECT_EQ(lan.to_string(), "a1a8");
+    EXPECT_EQ(result.score, search::mate - 1);
+    EXPECT_EQ(result.depth, 5);
+
+    // the threads searched copies
+    EXPECT_EQ(board, original);
+    EXPECT_TRUE(history.empty());
+}
+
+TEST(TranspositionTest, StoresAndReplacesEntries) {
+    using transposition::Bound;
+
+    transposition::Table table(1);
+
+    Move move(square(12), square(28), Move::DOUBLE_PUSH);
+    uint64_t hash = 0x123456789ABC0001;
+
+    EXPECT_FALSE(table.probe(hash));
+
+    table.store(hash, {move, -250, 6, Bound::LOWER});
+
+    auto entry = table.probe(hash);
+
+    ASSERT_TRUE(entry);
+    EXPECT_EQ(entry->move, move);
+    EXPECT_EQ(entry->score, -250);
+    EXPECT_EQ(entry->depth, 6);
+    EXPECT_EQ(entry->bound, Bound::LOWER);
+
+    // a much shallower bound does not replace a deeper one
+    table.store(hash, {Move(), 10, 2, Bound::UPPER});
+    EXPECT_EQ(table.probe(hash)->depth, 6);
+
+    // a shallow bound without a move keeps the move already stored
+    table.store(hash, {Move(), 10, 5, Bound::UPPER});
+    EXPECT_EQ(table.probe(hash)->move, move);
+    EXPECT_EQ(table.probe(hash)->bound, Bound::UPPER);
+
+    // same bucket, other key
+    EXPECT_FALSE(table.probe(hash ^ (uint64_t(1) << 63)));
+
+    // the bucket fills up, the entry of an older search goes first
+    table.new_search();
+
+    for (uint64_t other = 1; other <= 4; ++other) {
+        table.store(hash + (other << 32), {Move(), 0, 1, Bound::EXACT});
+    }
+
+    EXPECT_FALSE(table.probe(hash));
+
+    // the bucket is among the sampled ones
+    EXPECT_EQ(table.hashfull(), 4);
+
+    table.clear();
+    EXPECT_FALSE(table.probe(hash + (uint64_t(1) << 32)));
+}
+
+TEST(StagedGenerationTest, QuietChecksMatchPlayedQuiets) {
+    for (auto fen : staged_positions) {
+        Board board = notation::FEN::parse_string(fen);
+
+        generation::GenerationContext context(board);
+
+        if (context.in_check) continue;
+
+        generation::MoveList quiets, checks;
+        generation::generate_quiets(context, quiets);
+        generation::generate_quiet_checks(context, checks);
+
+        // play every quiet move and keep those leaving the enemy in check
+        std::vector<Move> expected;
+
+        for (const Move& move : quiets) {
+            auto state = board.play(move);
+
+            if (generation::GenerationContext(board).in_check)
+                expected.push_back(move);
+
+            board.unplay(move, state);
+        }
+
+        EXPECT_EQ(checks.size(), expected.size())
+            << std::format("FEN: {}", fen);
+
+        for (const Move& move : expected) {
+            EXPECT_TRUE(std::ranges::any_of(
+                checks, [&](const Move& m) { return m == move; }))
+                << std::format("FEN: {}\nmissing check {} -> {}", fen,
+                       (square_t)move.from(), (square_t)move.to());
+        }
+    }
+}
+
+// Walks every ray square by square until it hits a blocker
+bitboard slider_reference(
+    bitboard blockers, square index, std::initializer_list<int[2]> rays) {
+    bitboard moves = 0;
+
+    for (auto [drow, dcol] : rays) {
+        int row = index.row() + drow, col = index.column() + dcol;
+
+        for (; row >= 0 && row < 8 && col >= 0 && col < 8;
+            row += drow, col += dcol) {
+            square target = square::at(row, col);
+            moves |= target.bb();
+
+            if (blockers[target]) break;
+        }
+    }
+
+    return moves;
+}
+
+TEST(SliderLookupTest, MatchesRayWalk) {
+    namespace magic = generation::magic;
+
+    const magic::Backend selected = magic::get_backend();
+
+    for (auto backend : {magic::Backend::MAGIC, magic::Backend::PEXT}) {
+        if (!magic::set_backend(backend)) continue;
+
+        uint64_t seed = 0x9E3779B97F4A7C15;
+
+        auto random = [&]() {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            return seed;
+        };
+
+        for (square index = 0; index < 64; ++index) {
+            for (int sample = 0; sample < 256; ++sample) {
+                bitboard blockers = random() & random();
+
+                EXPECT_EQ(magic::rooks::get_avail_moves(blockers, index),
+                    slider_reference(
+                        blockers, index, {{1, 0}, {-1, 0}, {0, 1}, {0, -1}}))
+                    << std::format("rook on {}, backend {}", (square_t)index,
+                           (int)backend);
+
+                EXPECT_EQ(magic::bishops::get_avail_moves(blockers, index),
+                    slider_reference(
+                        blockers, index, {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}}))
+                    << std::format("bishop on {}, backend {}", (square_t)index,
+                           (int)backend);
+            }
+        }
+    }
+
+    magic::set_backend(selected);
+}
+
 void parse_test_cases_from_file(std::string cases_file) {
     toml::parse_result result = toml::parse_file(cases_file);
 
@@ -130,6 +970,38 @@ void parse_test_cases_from_file(std::string cases_file) {
                 fen.value(), move_count);
         }
     }
+
+    auto perft_cases = tbl["perft"]["cases"].as_array();
+
+    if (!perft_cases) return;
+
+    for (const auto& item : *perft_cases) {
+        const auto& tcase = *item.as_table();
+
+        auto name = tcase["name"].value<std::string>();
+        auto fen = tcase["fen"].value<std::string>();
+        auto nodes = tcase["nodes"].as_array();
+
+        if (!name || !fen || !nodes) {
+            std::println(stderr,
+                "ERROR:: Could not parse perft case, name, FEN or nodes is "
+                "missing");
+            continue;
+        }
+
+        core::test::PerftTestCase perft_case{
+            .name = name.value(),
+            .fen = fen.value(),
+            .nodes = {},
+            .fast_depth = tcase["fast_depth"].value_or(0),
+        };
+
+        for (const auto& count : *nodes) {
+            perft_case.nodes.push_back(count.value_or<uint64_t>(0));
+        }
+
+        core::test::PerftTestCases.push_back(perft_case);
+    }
 }
 
 }  // namespace core::test
@@ -140,5 +1012,13 @@ int main(int argc, char** argv) {
             .string());
 
     ::testing::InitGoogleTest(&argc, argv);
+
+    // gtest leaves the arguments it does not know about
+    for (int index = 1; index < argc; ++index) {
+        if (std::string_view(argv[index]) == "--perft-deep") {
+            core::test::perft_deep = true;
+        }
+    }
+
     return RUN_ALL_TESTS();
 }
@@ -0,0 +1,144 @@
+#include "transposition.hpp"
+
+#include <algorithm>
+#include <bit>
+
+core::transposition::Table::Table(size_t mib) {
+    size_t count = std::max<size_t>(1, (mib << 20) / sizeof(Bucket));
+
+    // a power of two so the bucket is picked by masking the hash
+    bucket_count = std::bit_floor(count);
+    buckets = std::make_unique<Bucket[]>(bucket_count);
+}
+
+uint64_t core::transposition::Table::pack(
+    const Result& result, uint8_t generation) {
+    return uint64_t(result.move.data) | uint64_t(uint16_t(result.score)) << 16 |
+           uint64_t(result.depth) << 32 | uint64_t(result.bound) << 40 |
+           uint64_t(generation) << 42;
+}
+
+core::transposition::Result core::transposition::Table::unpack(uint64_t data) {
+    Result result;
+
+    result.move.data = data & 0xFFFF;
+    result.score = int16_t(data >> 16);
+    result.depth = depth_of(data);
+    result.bound = Bound((data >> 40) & 0b11);
+
+    return result;
+}
+
+std::optional<core::transposition::Result> core::transposition::Table::probe(
+    uint64_t hash) const {
+    for (const Entry& entry : bucket_at(hash).entries) {
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+
+        if ((check ^ data) == hash) return unpack(data);
+    }
+
+    return std::nullopt;
+}
+
+/*
+ * Stores a result over the same position if present,
+ * unless the one kept is deeper and from the current search.
+ *
+ * Otherwise replaces the entry worth the least,
+ * shallow entries and those from older searches go first.
+ */
+void core::transposition::Table::store(uint64_t hash, const Result& result) {
+    uint8_t generation = this->generation.load(std::memory_order_relaxed);
+
+    Entry* replaced = nullptr;
+    int replaced_worth = INT32_MAX;
+
+    for (Entry& entry : bucket_at(hash).entries) {
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+
+        if ((check ^ data) == hash) {
+            bool stale = generation_of(data) != generation;
+
+            if (result.bound != Bound::EXACT && !stale &&
+                result.depth + 2 < depth_of(data)) {
+                return;
+            }
+
+            Result kept = result;
+
+            // a bound without a move still keeps the move found before
+            if (kept.move == Move()) kept.move = unpack(data).move;
+
+            data = pack(kept, generation);
+
+            entry.check.store(hash ^ data, std::memory_order_relaxed);
+            entry.data.store(data, std::memory_order_relaxed);
+
+            return;
+        }
+
+        int age = (generation - generation_of(data)) & generation_mask;
+        int worth = depth_of(data) - 8 * age;
+
+        if (worth < replaced_worth) {
+            replaced = &entry;
+            replaced_worth = worth;
+        }
+    }
+
+    uint64_t data = pack(result, generation);
+
+    replaced->check.store(hash ^ data, std::memory_order_relaxed);
+    replaced->data.store(data, std::memory_order_relaxed);
+}
+
+void core::transposition::Table::clear() {
+    for (size_t index = 0; index < bucket_count; ++index) {
+        for (Entry& entry : buckets[index].entries) {
+            entry.check.store(0, std::memory_order_relaxed);
+            entry.data.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    generation.store(0, std::memory_order_relaxed);
+    probes = 0;
+    hits = 0;
+}
+
+/*
+ * Samples the first thousand entries (or the whole table if smaller),
+ * counting the ones written during the current search.
+ */
+int core::transposition::Table::hashfull() const {
+    constexpr size_t per_bucket = sizeof(Bucket::entries) / sizeof(Entry);
+
+    size_t sampled = std::min<size_t>(1000 / per_bucket, bucket_count);
+
+    uint8_t generation = this->generation.load(std::memory_order_relaxed);
+
+    int used = 0;
+
+    for (size_t index = 0; index < sampled; ++index) {
+        for (const Entry& entry : buckets[index].entries) {
+            uint64_t data = entry.data.load(std::memory_order_relaxed);
+
+            if (Bound((data >> 40) & 0b11) != Bound::NONE &&
+                generation_of(data) == generation) {
+                ++used;
+            }
+        }
+    }
+
+    return used * 1000 / int(sampled * per_bucket);
+}
+
+void core::transposition::Table::add_stats(const Stats& local) {
+    probes.fetch_add(local.probes, std::memory_order_relaxed);
+    hits.fetch_add(local.hits, std::memory_order_relaxed);
+}
+
+core::transposition::Table::Stats core::transposition::Table::stats() const {
+    return {probes.load(), hits.load()};
+}
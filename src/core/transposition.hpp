@@ -0,0 +1,115 @@
+#pragma once
+
+#include <core/types.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+namespace core::transposition {
+
+// How the stored score relates to the real one
+enum class Bound : uint8_t { NONE, UPPER, LOWER, EXACT };
+
+// Search result of a position, unpacked from an entry
+struct Result {
+    Move move;
+    int16_t score;
+    uint8_t depth;
+    Bound bound;
+};
+
+/*
+ * Fixed size cache of search results, keyed by the position hash.
+ *
+ * Entries are grouped in buckets the size of a cache line.
+ * Safe to share between search threads without locks:
+ * the key is stored xored with the data,
+ * so an entry torn by two concurrent writes never matches.
+ *
+ * Each search bumps the generation, entries left by older searches
+ * are replaced first.
+ */
+class Table {
+   public:
+    struct Stats {
+        uint64_t probes = 0, hits = 0;
+
+        inline double hit_rate() const {
+            return probes ? double(hits) / probes : 0;
+        }
+    };
+
+    explicit Table(size_t mib);
+
+    std::optional<Result> probe(uint64_t hash) const;
+    void store(uint64_t hash, const Result& result);
+
+    // Loads the bucket of `hash` into the cache ahead of its probe
+    inline void prefetch(uint64_t hash) const {
+        __builtin_prefetch(&bucket_at(hash));
+    }
+
+    // Starts a new search, ageing every entry stored so far
+    inline void new_search() {
+        uint8_t current = generation.load(std::memory_order_relaxed);
+        generation.store(
+            (current + 1) & generation_mask, std::memory_order_relaxed);
+    }
+
+    void clear();
+
+    inline size_t size() const { return bucket_count * sizeof(Bucket); }
+
+    // Permill of the first entries used by the current search
+    int hashfull() const;
+
+    // probes and hits are gathered by each caller and added at the end
+    void add_stats(const Stats& local);
+    Stats stats() const;
+
+   private:
+    // 16 bytes: `check` holds the full key xored with `data`,
+    // so the key is verified without storing it apart.
+    //
+    // Data layout, from the lowest bit:
+    // move (16) | score (16) | depth (8) | bound (2) | generation (6)
+    // | unused (16)
+    struct Entry {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+
+    struct alignas(64) Bucket {
+        Entry entries[4];
+    };
+
+    static_assert(sizeof(Bucket) == 64);
+
+    static constexpr uint8_t generation_mask = 0x3F;
+
+    std::unique_ptr<Bucket[]> buckets;
+    size_t bucket_count;
+
+    // read by every search thread, only bumped between searches
+    std::atomic<uint8_t> generation = 0;
+
+    std::atomic<uint64_t> probes = 0, hits = 0;
+
+    inline Bucket& bucket_at(uint64_t hash) const {
+        return buckets[hash & (bucket_count - 1)];
+    }
+
+    static uint64_t pack(const Result& result, uint8_t generation);
+    static Result unpack(uint64_t data);
+
+    static inline uint8_t generation_of(uint64_t data) {
+        return (data >> 42) & generation_mask;
+    }
+
+    static inline uint8_t depth_of(uint64_t data) { return data >> 32; }
+};
+
+}  // namespace core::transposition
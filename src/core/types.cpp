@@ -1,121 +1,175 @@
 #include <core/types.hpp>
 
+#include <core/generation.hpp>
+#include <core/zobrist.hpp>
+
 #include <cassert>
+#include <utility>
+
+/*
+ * Returns the origin and destination of the rook
+ * for a castling king going from `from` to `to`.
+ */
+static std::pair<core::square, core::square> castling_rook(
+    core::square from, core::square to) {
+    using core::square;
+
+    // king side, the rook is on the h file
+    if (from > to) return {square::at(from.row(), 0), from.right()};
+
+    // queen side, the rook is on the a file
+    return {square::at(from.row(), 7), from.left()};
+}
 
 /*
  * Applies a `Move` to the state of a `Board`.
  *
  * Does not perform any validation of the legality of the move.
+ * The moved and captured pieces are read from the board.
  *
  * Returns the `Board::State` of the `Board` before applying the move.
  */
 const core::Board::State core::Board::play(const Move move) {
-    assert(move.moved.isValid());
+    State prev = static_cast<State&>(*this);
+
+    apply(move);
+
+    return prev;
+}
+
+/*
+ * Applies a `Move` without keeping anything to undo it,
+ * the caller keeps a copy of the board instead.
+ */
+void core::Board::apply(const Move move) {
+    square from = move.from();
+    square to = move.to();
+
+    Piece moved = piece(from);
+
+    assert(moved.isValid());
 
     State& state = static_cast<State&>(*this);
-    State prev = state;
 
-    // move the piece bit to its new position
-    colors[active_color] &= ~move.from.bb();
-    colors[active_color] |= move.to.bb();
-    pieces[move.moved] &= ~move.from.bb();
-    pieces[move.moved] |= move.to.bb();
+    namespace zobrist = core::zobrist;
+
+    // rights and en passant are xored back in once they are updated
+    state.hash ^= zobrist::castling_key(castling_availability);
+    state.hash ^= zobrist::en_passant_key(*this);
 
     // increase counter for 50 move rule
     ++state.halfmove_clock;
 
     // reset counter for 50 move rule
-    if (!move.target.isNone() || move.moved.isPawn()) {
+    if (move.is_capture() || moved.isPawn()) {
         state.halfmove_clock = 0;
     }
 
-    // remove the bit of the captured piece
-    if (!move.target.isNone()) {
-        colors[!active_color] &= ~move.to.bb();
-    }
+    // remove the captured piece
+    state.captured = Piece::NONE;
 
-    // clear the en en passant state
-    state.en_passant_target_square = square::out_of_bounds;
+    if (move.is_en_passant()) {
+        square capture = active_color ? to.down() : to.up();
 
-    // capture en passant
-    if (move.en_passant && !move.target.isNone()) {
-        square capture = active_color ? move.to.down() : move.to.up();
+        state.captured = Piece::PAWNS;
 
+        pawns &= ~capture.bb();
         colors[!active_color] &= ~capture.bb();
-    }
+        mailbox[capture] = Piece::NONE;
 
-    // set en passant due to double advance
-    if (move.en_passant && move.target.isNone()) {
-        state.en_passant_target_square = active_color ? move.from.up() : move.from.down();
+        state.hash ^= zobrist::piece_key(!active_color, Piece::PAWNS, capture);
+    } else if (move.is_capture()) {
+        state.captured = piece(to);
+
+        pieces[state.captured] &= ~to.bb();
+        colors[!active_color] &= ~to.bb();
+
+        state.hash ^= zobrist::piece_key(!active_color, state.captured, to);
     }
 
+    // move the piece bit to its new position
+    colors[active_color] ^= from.bb() | to.bb();
+    pieces[moved] ^= from.bb() | to.bb();
+    mailbox[from] = Piece::NONE;
+    mailbox[to] = moved;
+
+    state.hash ^= zobrist::piece_key(active_color, moved, from);
+    state.hash ^= zobrist::piece_key(active_color, moved, to);
+
     // promote pawn, switch bitboard
-    if (!move.promotion.isNone()) {
-        pieces[move.moved] ^= move.to.bb();
-        pieces[move.promotion] |= move.to.bb();
+    if (move.is_promotion()) {
+        pawns ^= to.bb();
+        pieces[move.promotion()] |= to.bb();
+        mailbox[to] = move.promotion();
+
+        state.hash ^= zobrist::piece_key(active_color, Piece::PAWNS, to);
+        state.hash ^= zobrist::piece_key(active_color, move.promotion(), to);
+    }
+
+    // clear the en en passant state
+    state.en_passant_target_square = square::out_of_bounds;
+
+    // set en passant due to double advance
+    if (move.is_double_push()) {
+        state.en_passant_target_square = active_color ? from.up() : from.down();
     }
 
     // if castling move the rook to the correct position
     // update the castling state
-    if (move.castle) {
-        bitboard rook_movement;
+    if (move.is_castle()) {
+        auto [rook_from, rook_to] = castling_rook(from, to);
 
         // get the bits needed to switch the rook
-        rook_movement =
-            active_color ? bitboard::masks::rank(0) : bitboard::masks::rank(7);
-
-        if (move.from > move.to) {
-            rook_movement &=
-                bitboard::masks::file(0) | bitboard::masks::file(2);
+        bitboard rook_movement = rook_from.bb() | rook_to.bb();
 
+        if (from > to) {
             set_castling_right(false);
         } else {
-            rook_movement &=
-                bitboard::masks::file(7) | bitboard::masks::file(4);
-
             set_castling_left(false);
         }
 
         rooks ^= rook_movement;
         colors[active_color] ^= rook_movement;
+        mailbox[rook_from] = Piece::NONE;
+        mailbox[rook_to] = Piece::ROOKS;
+
+        state.hash ^= zobrist::piece_key(active_color, Piece::ROOKS, rook_from);
+        state.hash ^= zobrist::piece_key(active_color, Piece::ROOKS, rook_to);
     }
 
     // if the king is moved lose both castling sides
-    if (move.moved.isKing()) {
+    if (moved.isKing()) {
         set_castling_left(false);
         set_castling_right(false);
     }
 
-    // if a rook is moved in a corner,
+    // if a rook leaves or is captured in a corner,
     // then remove that castling right
-    if (move.moved.isRook()) {
-        if (active_color.isWhite() && move.from == square::at(0, 0)) {
-            set_castling_right(false);
+    for (square corner : {from, to}) {
+        if (corner == square::at(0, 0)) {
+            castling_availability.white_right = false;
         }
 
-        if (active_color.isWhite() && move.from == square::at(0, 7)) {
-            set_castling_left(false);
+        if (corner == square::at(0, 7)) {
+            castling_availability.white_left = false;
         }
 
-        if (active_color.isBlack() && move.from == square::at(7, 0)) {
-            set_castling_right(false);
+        if (corner == square::at(7, 0)) {
+            castling_availability.black_right = false;
         }
 
-        if (active_color.isBlack() && move.from == square::at(7, 7)) {
-            set_castling_left(false);
+        if (corner == square::at(7, 7)) {
+            castling_availability.black_left = false;
         }
     }
 
-    // clear stray bits left after captures
-    bitboard all_pieces = all();
-
-    for (bitboard& bb : pieces) {
-        bb &= all_pieces;
-    }
-
     active_color = !active_color;
 
-    return prev;
+    state.hash ^= zobrist::keys.side;
+    state.hash ^= zobrist::castling_key(castling_availability);
+    state.hash ^= zobrist::en_passant_key(*this);
+
+    generation::update_state(*this);
 }
 
 /*
@@ -126,55 +180,57 @@ const core::Board::State core::Board::play(const Move move) {
  * Does not perform any validation of the `Move` or `Board::State`.
  */
 void core::Board::unplay(const Move move, const State prev) {
-    assert(move.moved.isValid());
+    square from = move.from();
+    square to = move.to();
+
+    // read before the state is overwritten
+    Piece captured = this->captured;
 
     // return the board to its previous state
     static_cast<State&>(*this) = prev;
 
+    // if there was a promotion
+    // turn the promoted piece back into a pawn
+    if (move.is_promotion()) {
+        pieces[move.promotion()] ^= to.bb();
+        pawns ^= to.bb();
+        mailbox[to] = Piece::PAWNS;
+    }
+
+    Piece moved = piece(to);
+
+    assert(moved.isValid());
+
     // move the piece to its original position
-    // if there is a promotion this adds an extra pawn *
-    colors[active_color] &= ~move.to.bb();
-    colors[active_color] |= move.from.bb();
-    pieces[move.moved] &= ~move.to.bb();
-    pieces[move.moved] |= move.from.bb();
+    colors[active_color] ^= from.bb() | to.bb();
+    pieces[moved] ^= from.bb() | to.bb();
+    mailbox[from] = moved;
+    mailbox[to] = Piece::NONE;
 
     // if a piece was captured then add it back
-    if (!move.target.isNone() && !move.en_passant) {
-        pieces[move.target] |= move.to.bb();
-        colors[!active_color] |= move.to.bb();
-    }
+    if (!captured.isNone()) {
+        square capture = to;
 
-    // if a pawn was captured via en passant
-    // then put it back
-    if (!move.target.isNone() && move.en_passant) {
-        square pawn = active_color ? move.to.down() : move.to.up();
-        pieces[move.target] |= pawn.bb();
-        colors[!active_color] |= pawn.bb();
-    }
+        // a pawn captured via en passant is behind the target
+        if (move.is_en_passant()) {
+            capture = active_color ? to.down() : to.up();
+        }
 
-    // if there was a promotion
-    // delete the promoted piece
-    if (!move.promotion.isNone()) {
-        pieces[move.promotion] ^= move.to.bb();
+        pieces[captured] |= capture.bb();
+        colors[!active_color] |= capture.bb();
+        mailbox[capture] = captured;
     }
 
     // if there was a castle then
     // move the rook back to its original position
-    if (move.castle) {
-        bitboard rook_movement;
+    if (move.is_castle()) {
+        auto [rook_from, rook_to] = castling_rook(from, to);
 
-        rook_movement =
-            active_color ? bitboard::masks::rank(0) : bitboard::masks::rank(7);
-
-        if (move.from > move.to) {
-            rook_movement &=
-                bitboard::masks::file(0) | bitboard::masks::file(2);
-        } else {
-            rook_movement &=
-                bitboard::masks::file(7) | bitboard::masks::file(4);
-        }
+        bitboard rook_movement = rook_from.bb() | rook_to.bb();
 
         rooks ^= rook_movement;
         colors[active_color] ^= rook_movement;
+        mailbox[rook_from] = Piece::ROOKS;
+        mailbox[rook_to] = Piece::NONE;
     }
 }
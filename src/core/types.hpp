@@ -2,6 +2,8 @@
 
 #include <stdint.h>
 
+#include <type_traits>
+
 namespace core {
 
 typedef uint8_t square_t;
@@ -235,23 +237,64 @@ struct Piece : public LiteralWrapper<piece_t> {
     inline constexpr bool isValid() const { return value_ < NONE; }
 };
 
+/*
+ * Move packed in 16 bits.
+ *
+ *  15    12 11         6 5          0
+ * | flags  |     to     |    from    |
+ *
+ * The moved and captured pieces are not stored,
+ * they are read from the board that plays the move.
+ */
 struct Move {
-    square from;
-    square to;
+    // clang-format off
+    static constexpr uint8_t QUIET       = 0b0000,
+                             DOUBLE_PUSH = 0b0001,
+                             CASTLE      = 0b0010,
+                             CAPTURE     = 0b0100,
+                             EN_PASSANT  = 0b0101,
+                             PROMOTION   = 0b1000; // + promoted piece - KNIGHTS
+    // clang-format on
 
-    Piece moved = Piece::NONE;
-    Piece target = Piece::NONE;
+    uint16_t data = 0;
 
-    Piece promotion = Piece::NONE;
+    constexpr Move() = default;
 
-    // clang-format off
-    bool en_passant : 1 = 0; // set when (enabling ep) or (taking ep)
-    bool castle     : 1 = 0; // set when castling
-    bool check      : 1 = 0; // set when moving piece causes check
-    bool mate       : 1 = 0; // set when check causes mate
-    // clang-format on
+    constexpr Move(square from, square to, uint8_t flags = QUIET)
+        : data(from | (to << 6) | (flags << 12)) {}
+
+    // Promotion to `piece`, a capture if `capture` is set
+    static constexpr Move promote(
+        square from, square to, Piece piece, bool capture = false) {
+        return Move(from, to,
+            PROMOTION | (capture ? CAPTURE : 0) | (piece - Piece::KNIGHTS));
+    }
+
+    inline constexpr square from() const { return data & 0x3F; }
+    inline constexpr square to() const { return (data >> 6) & 0x3F; }
+    inline constexpr uint8_t flags() const { return data >> 12; }
+
+    inline constexpr bool is_capture() const { return flags() & CAPTURE; }
+    inline constexpr bool is_promotion() const { return flags() & PROMOTION; }
+    inline constexpr bool is_castle() const { return flags() == CASTLE; }
+    inline constexpr bool is_en_passant() const {
+        return flags() == EN_PASSANT;
+    }
+    inline constexpr bool is_double_push() const {
+        return flags() == DOUBLE_PUSH;
+    }
+
+    inline constexpr Piece promotion() const {
+        if (!is_promotion()) return Piece::NONE;
+
+        return Piece::KNIGHTS + (flags() & 0b11);
+    }
+
+    constexpr bool operator==(const Move &other) const = default;
 };
 
+static_assert(sizeof(Move) == 2);
+
 /*
  * Represents pieces distributions and colors
  */
@@ -263,7 +306,15 @@ struct Positions {
     union  { bitboard pieces[6];
     struct { bitboard_t pawns, knights, bishops, rooks, queens, kings; }; };
 
-    Positions() : colors{bitboard(0)}, pieces{bitboard(0)} {}
+    // clang-format on
+
+    // Piece standing on each square, NONE if empty.
+    // Kept in sync with the bitboards for O(1) lookups.
+    piece_t mailbox[64];
+
+    Positions() : colors{bitboard(0)}, pieces{bitboard(0)} {
+        for (piece_t& piece : mailbox) piece = Piece::NONE;
+    }
 
     inline bitboard all() const { return white | black; }
 
@@ -271,13 +322,7 @@ struct Positions {
         return Color::Both[bitboard(white)[index]];
     }
 
-    inline Piece piece(square index) const {
-        for (auto piece : Piece::All) {
-            if (pieces[piece][index]) return piece;
-        }
-
-        return Piece::NONE;
-    }
+    inline Piece piece(square index) const { return mailbox[index]; }
 
     constexpr inline bool operator==(const Positions &other) const {
         for (auto piece : Piece::All) {
@@ -288,6 +333,10 @@ struct Positions {
 
         if (this->black != other.black) return false;
 
+        for (square index = 0; index < 64; ++index) {
+            if (this->mailbox[index] != other.mailbox[index]) return false;
+        }
+
         return true;
     }
 };
@@ -324,6 +373,28 @@ struct State {
     // It starts at 1 and is incremented after Black's move.
     uint16_t fullmove_number = 1;
 
+    // The piece captured by the move that led to this state,
+    // packed moves don't carry it so `unplay` reads it from here
+    Piece captured = Piece::NONE;
+
+    // Fields above fit in the first 8 bytes, the bitboards follow
+
+    // Zobrist key of the position,
+    // kept up to date by `Board::play` and restored by `unplay`
+    uint64_t hash = 0;
+
+    // Check and pin data of the position,
+    // set by `generation::update_state` after every move
+
+    // enemy pieces giving check to the side to move
+    bitboard checkers = 0;
+
+    // allied pieces pinned to their king
+    bitboard pinned = 0;
+
+    // squares attacked by the enemy, the allied king not blocking
+    bitboard king_danger = 0;
+
     inline bool get_castling_left() const {
         return active_color ? castling_availability.white_left
                             : castling_availability.black_left;
@@ -375,13 +446,19 @@ struct State {
 
 /*
  * Represents game state
+ *
+ * Trivially copyable and aligned to a cache line (three lines in total),
+ * so it can be copied instead of being unplayed (copy-make).
  * */
-struct Board : public Positions, public State {
+struct alignas(64) Board : public Positions, public State {
     Board() : Positions() {}
 
     const State play(const Move move);
     void unplay(const Move move, const State prev);
 
+    // `play` without saving the previous state, for copy-make
+    void apply(const Move move);
+
     inline bitboard allies() const { return colors[active_color]; }
 
     inline bitboard allied(Piece piece) const {
@@ -394,11 +471,18 @@ struct Board : public Positions, public State {
         return pieces[piece] & colors[!active_color];
     }
 
+    inline bitboard pieces_of(Color color, Piece piece) const {
+        return pieces[piece] & colors[color];
+    }
+
     constexpr inline bool operator==(const Board &other) const {
         return Positions::operator==(other) && State::operator==(other);
     }
 };
 
+static_assert(sizeof(Board) == 192);
+static_assert(std::is_trivially_copyable_v<Board>);
+
 #else
 #undef CORE_PRIMITIVES_ONLY
 #endif
@@ -0,0 +1,97 @@
+#include "zobrist.hpp"
+
+#include <bit>
+
+namespace core {
+
+consteval zobrist::Keys initialize_keys() {
+    zobrist::Keys keys = {};
+
+    // xorshift64*, any fixed seed works
+    uint64_t seed = 0x9E3779B97F4A7C15;
+
+    auto random = [&]() {
+        seed ^= seed >> 12;
+        seed ^= seed << 25;
+        seed ^= seed >> 27;
+        return seed * 0x2545F4914F6CDD1D;
+    };
+
+    for (auto& color : keys.pieces)
+        for (auto& piece : color)
+            for (auto& key : piece) key = random();
+
+    keys.side = random();
+
+    for (auto& key : keys.castling) key = random();
+    for (auto& key : keys.en_passant) key = random();
+
+    return keys;
+}
+
+constexpr zobrist::Keys keys_table = initialize_keys();
+
+const zobrist::Keys zobrist::keys = keys_table;
+
+/*
+ * Hashes a position from scratch.
+ *
+ * Covers the pieces, the side to move, the castling rights
+ * and the en passant target, not the move counters.
+ */
+uint64_t zobrist::hash(const Board& board) {
+    uint64_t hash = 0;
+
+    for (Color color : Color::Both) {
+        for (Piece piece : Piece::All) {
+            bitboard pieces = board.pieces_of(color, piece);
+
+            for (; pieces != 0; pieces ^= pieces.LSB()) {
+                square index = std::countr_zero((bitboard_t)pieces);
+
+                hash ^= keys_table.pieces[color][piece][index];
+            }
+        }
+    }
+
+    if (board.active_color.isWhite()) hash ^= keys_table.side;
+
+    hash ^= zobrist::castling_key(board.castling_availability);
+    hash ^= zobrist::en_passant_key(board);
+
+    return hash;
+}
+
+uint64_t zobrist::castling_key(Board::State::Castling castling) {
+    uint64_t key = 0;
+
+    if (castling.white_left) key ^= keys_table.castling[0];
+    if (castling.white_right) key ^= keys_table.castling[1];
+    if (castling.black_left) key ^= keys_table.castling[2];
+    if (castling.black_right) key ^= keys_table.castling[3];
+
+    return key;
+}
+
+/*
+ * Only hashes the en passant file if a pawn of the side to move
+ * attacks the target square, otherwise the position is the same
+ * as one without a target and has to hash the same.
+ */
+uint64_t zobrist::en_passant_key(const Board& board) {
+    square target = board.en_passant_target_square;
+
+    if (target == square::out_of_bounds) return 0;
+
+    bitboard attackers = target.bb();
+    attackers = (attackers.exclude(bitboard::masks::file(0)) >> 1) |
+        (attackers.exclude(bitboard::masks::file(7)) << 1);
+
+    attackers = attackers.backward(board.active_color, 8);
+
+    if (attackers.mask(board.allied(Piece::PAWNS)) == 0) return 0;
+
+    return keys_table.en_passant[target.column()];
+}
+
+}  // namespace core
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <core/types.hpp>
+
+#include <array>
+#include <cstdint>
+
+namespace core::zobrist {
+
+/*
+ * Random keys xored together to hash a position,
+ * generated at compile time so every build hashes the same.
+ *
+ * `Board::play` updates `Board::hash` with them incrementally,
+ * `hash` recomputes it from scratch.
+ */
+struct Keys {
+    // one key per piece of each color on each square
+    std::array<std::array<std::array<uint64_t, 64>, 6>, 2> pieces;
+
+    // white to move
+    uint64_t side;
+
+    // white left, white right, black left, black right
+    std::array<uint64_t, 4> castling;
+
+    // file of the en passant target square
+    std::array<uint64_t, 8> en_passant;
+};
+
+extern const Keys keys;
+
+uint64_t hash(const Board& board);
+
+// Keys of the parts of the state, 0 for the parts that are not set
+
+uint64_t castling_key(Board::State::Castling castling);
+uint64_t en_passant_key(const Board& board);
+
+inline uint64_t piece_key(Color color, Piece piece, square index) {
+    return keys.pieces[color][piece][index];
+}
+
+}  // namespace core::zobrist
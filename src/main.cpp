@@ -1,15 +1,26 @@
+#include "bench.hpp"
+
 #include <core/generation.hpp>
+#include <core/history.hpp>
 #include <core/notation.hpp>
+#include <core/search.hpp>
 #include <core/types.hpp>
 
+#include <chrono>
+#include <cmath>
 #include <exception>
+#include <format>
 #include <iostream>
 #include <iterator>
 #include <print>
 #include <random>
+#include <span>
 #include <string>
+#include <string_view>
+#include <vector>
 
 void play_game(const std::string& fen_str);
+int search_position(std::span<const std::string_view> args);
 
 void show_nested_exception(const std::exception& e, int level = 0) {
     std::println(std::cerr, "{}{}", std::string(level * 2, ' '), e.what());
@@ -21,7 +32,18 @@ void show_nested_exception(const std::exception& e, int level = 0) {
     }
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    std::vector<std::string_view> args(argv + 1, argv + argc);
+
+    // non interactive commands
+    if (!args.empty() && args[0] == "bench") {
+        return bench::run(std::span(args).subspan(1));
+    }
+
+    if (!args.empty() && args[0] == "search") {
+        return search_position(std::span(args).subspan(1));
+    }
+
     while (true) {
         std::println("Start a new game");
         std::println(
@@ -91,8 +113,20 @@ void play_game(const std::string& fen_str) {
         return;
     }
 
+    core::History history;
+
     std::mt19937 gen(42);  // fixed seed
     while (true) {
+        if (history.is_threefold_repetition(board)) {
+            std::println("Draw by threefold repetition");
+            return;
+        }
+
+        if (history.is_fifty_move_draw(board)) {
+            std::println("Draw by the fifty-move rule");
+            return;
+        }
+
         auto moves = core::generation::generate_moves(board);
 
         if (moves.empty()) {
@@ -123,7 +157,7 @@ void play_game(const std::string& fen_str) {
 
         for (auto m : moves) {
             if ((selected_move = selected.matches_move(m))) {
-                board.play(m);
+                history.play(board, m);
                 // std::println("INFO:: Played move {} {} {} {}",
                 //     (core::square_t)m.from, (core::square_t)m.to,
                 //     core::notation::piece_toname(m.moved),
@@ -142,3 +176,100 @@ void play_game(const std::string& fen_str) {
         // }
     }
 }
+
+/*
+ * Usage: engine search [--depth N] [--nodes N] [--time ms] [--hash MiB]
+ *                      [--threads N] [fen]
+ *
+ * Searches a position and prints every completed iteration,
+ * --threads runs a Lazy SMP search on that many threads.
+ */
+int search_position(std::span<const std::string_view> args) {
+    core::search::Limits limits;
+    size_t hash_mib = 16;
+    unsigned threads = 1;
+    std::string fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    try {
+        for (size_t index = 0; index < args.size(); ++index) {
+            auto arg = args[index];
+            bool has_value = index + 1 < args.size();
+
+            if (arg == "--depth" && has_value) {
+                limits.depth = std::stoi(std::string(args[++index]));
+            } else if (arg == "--nodes" && has_value) {
+                limits.nodes = std::stoull(std::string(args[++index]));
+            } else if (arg == "--time" && has_value) {
+                limits.time = std::chrono::milliseconds(
+                    std::stoll(std::string(args[++index])));
+            } else if (arg == "--hash" && has_value) {
+                hash_mib = std::stoull(std::string(args[++index]));
+            } else if (arg == "--threads" && has_value) {
+                threads = std::stoul(std::string(args[++index]));
+            } else {
+                fen = arg;
+            }
+        }
+    } catch (const std::exception&) {
+        std::println(std::cerr,
+            "Usage: engine search [--depth N] [--nodes N] [--time ms] "
+            "[--hash MiB] [--threads N] [fen]");
+        return 2;
+    }
+
+    core::Board board;
+
+    try {
+        board = core::notation::FEN::parse_string(fen);
+    } catch (const core::notation::parse_error& err) {
+        show_nested_exception(err);
+        return 1;
+    }
+
+    core::History history;
+
+    core::transposition::Table table(hash_mib);
+
+    core::search::LazySmp search(board, history, limits, table, threads);
+
+    auto result = search.run([](const core::search::Iteration& iteration) {
+        std::string score;
+
+        if (std::abs(iteration.score) >= core::search::mate_bound) {
+            int plies = core::search::mate - std::abs(iteration.score);
+            int moves = (plies + 1) / 2;
+
+            score = std::format("mate {}", iteration.score > 0 ? moves : -moves);
+        } else {
+            score = std::format("cp {}", iteration.score);
+        }
+
+        std::string pv;
+
+        for (auto move : iteration.pv) {
+            core::notation::MoveLAN lan =
+                core::notation::MoveLAN::from_move(move);
+            pv += " " + lan.to_string();
+        }
+
+        std::println(
+            "depth {} score {} nodes {} nps {:.0f} hashfull {} time {:.0f} pv{}",
+            iteration.depth, score, iteration.nodes, iteration.nps(),
+            iteration.hashfull, iteration.elapsed.count() * 1000, pv);
+    });
+
+    std::println("nodes {} on {} threads", result.nodes, search.threads());
+
+    auto stats = table.stats();
+
+    std::println("hash hits {} of {} probes ({:.1f}%)", stats.hits,
+        stats.probes, stats.hit_rate() * 100);
+
+    if (!result.pv.empty()) {
+        core::notation::MoveLAN best =
+            core::notation::MoveLAN::from_move(result.pv[0]);
+        std::println("bestmove {}", best.to_string());
+    }
+
+    return 0;
+}
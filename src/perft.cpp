@@ -0,0 +1,205 @@
+#include <core/notation.hpp>
+#include <core/perft.hpp>
+#include <core/types.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+constexpr std::string_view start_position =
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+void show_nested_exception(const std::exception& e, int level = 0) {
+    std::println(std::cerr, "{}{}", std::string(level * 2, ' '), e.what());
+
+    try {
+        std::rethrow_if_nested(e);
+    } catch (const std::exception& nested) {
+        show_nested_exception(nested, level + 1);
+    }
+}
+
+struct Arguments {
+    int depth = 0;
+    std::string fen = std::string(start_position);
+
+    core::perft::ParallelOptions parallel;
+    bool use_parallel = false;
+
+    // size of the subtree count cache, none if 0
+    size_t hash_mib = 0;
+    bool scaling = false;
+};
+
+/*
+ * Returns the value following an option, throws if there is none.
+ */
+std::string option_value(int& index, int argc, char* argv[]) {
+    if (index + 1 >= argc) {
+        throw std::invalid_argument(
+            std::format("Missing value for '{}'", argv[index]));
+    }
+
+    return argv[++index];
+}
+
+Arguments parse_arguments(int argc, char* argv[]) {
+    Arguments args;
+    bool has_depth = false;
+
+    for (int index = 1; index < argc; ++index) {
+        std::string_view arg = argv[index];
+
+        if (arg == "--threads") {
+            args.parallel.threads = std::stoi(option_value(index, argc, argv));
+            args.use_parallel = true;
+        } else if (arg == "--split") {
+            args.parallel.split_depth =
+                std::stoi(option_value(index, argc, argv));
+            args.use_parallel = true;
+        } else if (arg == "--hash") {
+            args.hash_mib = std::stoul(option_value(index, argc, argv));
+        } else if (arg == "--scaling") {
+            args.scaling = true;
+        } else if (!has_depth) {
+            args.depth = std::stoi(std::string(arg));
+            has_depth = true;
+        } else {
+            args.fen = arg;
+        }
+    }
+
+    if (!has_depth) throw std::invalid_argument("Missing depth");
+
+    return args;
+}
+
+/*
+ * Runs the parallel perft from 1 up to every hardware thread
+ * and prints the speedup over a single worker.
+ */
+void report_scaling(const core::Board& board, const Arguments& args) {
+    unsigned max_threads = args.parallel.threads;
+
+    if (max_threads == 0)
+        max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    double single = 0;
+
+    std::println("{:>7} {:>12} {:>10} {:>14} {:>8}", "threads", "nodes",
+        "time (s)", "nps", "speedup");
+
+    for (unsigned threads = 1; threads <= max_threads; ++threads) {
+        auto options = args.parallel;
+        options.threads = threads;
+
+        // every run starts from an empty cache
+        if (options.table) options.table->clear();
+
+        auto start = std::chrono::steady_clock::now();
+
+        uint64_t nodes = 0;
+
+        for (auto [move, count] :
+            core::perft::divide_parallel(board, args.depth, options)) {
+            nodes += count;
+        }
+
+        auto elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start);
+
+        if (threads == 1) single = elapsed.count();
+
+        std::println("{:>7} {:>12} {:>10.3f} {:>14.0f} {:>8.2f}", threads,
+            nodes, elapsed.count(), nodes / elapsed.count(),
+            single / elapsed.count());
+    }
+}
+
+/*
+ * Usage: perft <depth> [fen] [--threads N] [--split D] [--hash MiB] [--scaling]
+ *
+ * Prints the nodes under each root move (divide),
+ * then the total nodes, the elapsed time and the nodes per second.
+ *
+ * --threads and --split run the subtrees on a pool of workers,
+ * --hash caches subtree counts in a table of the given size,
+ * --scaling reports the parallel run from 1 to N threads instead.
+ */
+int main(int argc, char* argv[]) {
+    Arguments args;
+
+    try {
+        args = parse_arguments(argc, argv);
+    } catch (const std::exception& err) {
+        std::println(std::cerr, "Error:: {}", err.what());
+        std::println(std::cerr,
+            "Usage: {} <depth> [fen] [--threads N] [--split D] [--hash MiB] [--scaling]",
+            argv[0]);
+        return 1;
+    }
+
+    int depth = args.depth;
+
+    core::Board board;
+
+    try {
+        board = core::notation::FEN::parse_string(args.fen);
+    } catch (const core::notation::parse_error& err) {
+        show_nested_exception(err);
+        return 1;
+    }
+
+    std::unique_ptr<core::perft::HashTable> table;
+
+    if (args.hash_mib > 0) {
+        table = std::make_unique<core::perft::HashTable>(args.hash_mib);
+        args.parallel.table = table.get();
+    }
+
+    if (args.scaling) {
+        report_scaling(board, args);
+        return 0;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto divided = args.use_parallel
+        ? core::perft::divide_parallel(board, depth, args.parallel)
+        : core::perft::divide(board, depth, table.get());
+
+    auto elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start);
+
+    uint64_t nodes = 0;
+
+    for (auto [move, count] : divided) {
+        auto lan = core::notation::MoveLAN::from_move(move);
+
+        std::println("{}: {}", lan.to_string(), count);
+
+        nodes += count;
+    }
+
+    // depth 0 is the root position itself
+    if (depth <= 0) nodes = 1;
+
+    std::println("");
+    std::println("nodes: {}", nodes);
+    std::println("time:  {:.3f} s", elapsed.count());
+    std::println("nps:   {:.0f}", nodes / elapsed.count());
+
+    if (table) {
+        auto stats = table->stats();
+
+        std::println("hash:  {} MiB, {} probes, {:.1f}% hits",
+            table->size() >> 20, stats.probes, stats.hit_rate() * 100);
+    }
+}